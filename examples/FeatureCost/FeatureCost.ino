@@ -0,0 +1,131 @@
+#include <ProximitySensor.h>
+#include <TAdcPinInput.h>
+
+// Measures the cost of the state machine for the features the library was
+// built with (see PROXIMITY_FEATURES in ProximitySensor.h). Build it with
+// e.g. -DPROXIMITY_FEATURES=0x00 in compiler.cpp.extra_flags, or run
+// extras/features.sh to build and size every combination.
+//
+// Prints one line, "features <mask> cycles <cycles per update>", measured
+// with Timer1 at the full CPU clock over the approach stream of the
+// SensorBenchmark example.
+
+// Exposes the protected state machine entry point.
+class CostSensor : public ProximitySensor {
+public:
+  CostSensor() : ProximitySensor(&TAdcPinInput<11>::instance(), &TAdcPinInput<12>::instance()) {}
+  using ProximitySensor::update;
+};
+
+CostSensor sensor;
+
+#if PROXIMITY_FEATURE(SAMPLE_CALLBACK)
+void onSample(void*) {
+}
+#endif
+
+#if PROXIMITY_FEATURE(STATE_CALLBACK)
+uint16_t transitions;
+
+void onStateChange(void*, ProximitySensor::State, ProximitySensor::State, uint32_t) {
+  transitions++;
+}
+#endif
+
+volatile uint16_t timer1Overflows;
+
+ISR(TIMER1_OVF_vect) {
+  timer1Overflows++;
+}
+
+void startCycleCounter() {
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TCNT1 = 0;
+  TIFR1 = _BV(TOV1);
+  timer1Overflows = 0;
+  TIMSK1 = _BV(TOIE1);
+  TCCR1B = _BV(CS10); // clk/1
+}
+
+uint32_t readCycleCounter() {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t count = TCNT1;
+  uint32_t overflows = timer1Overflows;
+  // Account for an overflow that occurred after interrupts were disabled.
+  if ((TIFR1 & _BV(TOV1)) && count < 0x8000) overflows++;
+  SREG = sreg;
+  return (overflows << 16) | count;
+}
+
+// Same LCG and approach stream as the SensorBenchmark example.
+uint16_t noiseState = 3;
+
+uint8_t noise(uint8_t span) {
+  noiseState = noiseState * 25173 + 13849;
+  return (noiseState >> 8) % span;
+}
+
+uint16_t approachSample(uint16_t i) {
+  i %= 300;
+  if (i < 100) return 300 + noise(3);
+  if (i < 150) return 300 + (i - 100) * 120 / 50;
+  if (i < 250) return 420 + noise(3);
+  return 420 - (i - 250) * 120 / 50;
+}
+
+const uint16_t STREAM_LENGTH = 1200;
+const uint8_t BLOCK = 64;
+
+void setup() {
+
+  Serial.begin(9600);
+  while (!Serial);
+
+  // Use every enabled feature so that none of them is left out of the image.
+#if PROXIMITY_FEATURE(SAMPLE_CALLBACK)
+  sensor.setOnSampleCallback(&onSample, 0);
+#endif
+#if PROXIMITY_FEATURE(STATE_CALLBACK)
+  sensor.setOnStateChangeCallback(&onStateChange, 0);
+#endif
+#if PROXIMITY_FEATURE(TIMEOUTS)
+  sensor.setProximityTimeoutMs(5000);
+  sensor.setTouchTimeoutMs(5000);
+#endif
+#if PROXIMITY_FEATURE(DEBOUNCE)
+  sensor.setDelayMs(10);
+#endif
+#if PROXIMITY_FEATURE(RESEED)
+  sensor.setFilterReseedThreshold(32);
+#endif
+
+  uint16_t block[BLOCK];
+  uint32_t cycles = 0;
+  for (uint16_t i = 0; i < STREAM_LENGTH; i += BLOCK) {
+    // Stream generation is kept outside of the measured region.
+    for (uint8_t j = 0; j < BLOCK; j++) block[j] = approachSample(i + j);
+    startCycleCounter();
+    for (uint8_t j = 0; j < BLOCK && i + j < STREAM_LENGTH; j++) sensor.update((uint32_t)block[j] << 8);
+    cycles += readCycleCounter();
+  }
+
+  // Release Timer1 for the application.
+  TIMSK1 = 0;
+  TCCR1B = 0;
+
+  Serial.print("features 0x");
+  Serial.print(PROXIMITY_FEATURES, HEX);
+  Serial.print(" cycles ");
+  Serial.println((float)cycles / STREAM_LENGTH, 0);
+
+#if PROXIMITY_FEATURE(STATISTICS)
+  Serial.print("# idle for ");
+  Serial.print(sensor.getIdleDurationMs());
+  Serial.println(" ms");
+#endif
+}
+
+void loop() {
+}
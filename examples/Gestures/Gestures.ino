@@ -0,0 +1,64 @@
+#include <ProximitySensor.h>
+#include <ProximitySensorArray.h>
+#include <GestureRecognizer.h>
+#include <TAdcPinInput.h>
+
+// Three pads in a row, all using PB4/ADC11/A8 as the reference pin.
+// The pads are PB5/ADC12/A9, PB6/ADC13/A10 and PD7/ADC10/A7.
+ProximitySensor left(&TAdcPinInput<11>::instance(),&TAdcPinInput<12>::instance());
+ProximitySensor center(&TAdcPinInput<11>::instance(),&TAdcPinInput<13>::instance());
+ProximitySensor right(&TAdcPinInput<11>::instance(),&TAdcPinInput<10>::instance());
+
+// Pads in their physical order, left to right.
+ProximitySensor* pads[] = { &left, &center, &right };
+
+ProximitySensorArray array(pads, 3);
+
+// Constructed after the sensors so that it can register with them.
+TGestureRecognizer<3> gestures(pads);
+
+void setup() {
+
+  Serial.begin(9600);
+
+  // Called once in during setup. Configures ADC.
+  ProximitySensor::begin();
+
+  for (uint8_t i = 0; i < 3; i++) {
+    pads[i]->setProximityThreshold(5);
+    pads[i]->setTouchThreshold(15);
+  }
+
+  // Report a long press after one second of contact.
+  gestures.setLongPressMs(1000);
+
+  // A swipe must cross all three pads.
+  gestures.setSwipeMinPads(3);
+
+}
+
+void loop() {
+
+  // Sample all pads. Gestures are recognized as the pads change state.
+  array.update();
+
+  // Report the gestures recognized so far.
+  GestureRecognizer::Gesture gesture;
+  while (gestures.poll(gesture)) {
+    switch (gesture.type) {
+    case GestureRecognizer::TAP: Serial.print("tap "); break;
+    case GestureRecognizer::DOUBLE_TAP: Serial.print("double tap "); break;
+    case GestureRecognizer::LONG_PRESS: Serial.print("long press "); break;
+    case GestureRecognizer::SWIPE_FORWARD: Serial.print("swipe right "); break;
+    case GestureRecognizer::SWIPE_BACKWARD: Serial.print("swipe left "); break;
+    }
+    Serial.print(gesture.pad);
+    if (gesture.lastPad != gesture.pad) {
+      Serial.print("-");
+      Serial.print(gesture.lastPad);
+    }
+    Serial.print(" at ");
+    Serial.println(gesture.timeMs);
+  }
+
+}
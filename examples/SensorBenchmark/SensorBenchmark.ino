@@ -0,0 +1,170 @@
+#include <ProximitySensor.h>
+#include <TAdcPinInput.h>
+
+// On-target counterpart of the host benchmark in extras/host/bench.
+// Prints the same case names with CPU cycles per sample measured with Timer1
+// running at the full CPU clock. The Timer0 interrupt that maintains millis()
+// remains enabled, so figures include its small overhead.
+//
+// The logic cases feed the same synthetic streams as the host benchmark, but
+// millis() advances in real time here rather than in 10 ms steps per sample,
+// so the debounce and timeout paths are taken at different points.
+
+// Exposes the protected state machine entry points.
+class BenchSensor : public ProximitySensor {
+public:
+  BenchSensor() : ProximitySensor(&TAdcPinInput<11>::instance(), &TAdcPinInput<12>::instance()) {}
+  using ProximitySensor::update;
+  using ProximitySensor::updateMovingAverage;
+};
+
+volatile uint16_t timer1Overflows;
+
+ISR(TIMER1_OVF_vect) {
+  timer1Overflows++;
+}
+
+void startCycleCounter() {
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TCNT1 = 0;
+  TIFR1 = _BV(TOV1);
+  timer1Overflows = 0;
+  TIMSK1 = _BV(TOIE1);
+  TCCR1B = _BV(CS10); // clk/1
+}
+
+uint32_t readCycleCounter() {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t count = TCNT1;
+  uint32_t overflows = timer1Overflows;
+  // Account for an overflow that occurred after interrupts were disabled.
+  if ((TIFR1 & _BV(TOV1)) && count < 0x8000) overflows++;
+  SREG = sreg;
+  return (overflows << 16) | count;
+}
+
+// Same LCG and stream shapes as the host benchmark.
+uint16_t noiseState;
+
+uint8_t noise(uint8_t span) {
+  noiseState = noiseState * 25173 + 13849;
+  return (noiseState >> 8) % span;
+}
+
+enum SampleStream { FLAT, APPROACH, THRESHOLD };
+
+uint16_t nextSample(SampleStream stream, uint16_t i) {
+  switch (stream) {
+  case FLAT:
+    return 298 + noise(5);
+  case APPROACH:
+    i %= 300;
+    if (i < 100) return 300 + noise(3);
+    if (i < 150) return 300 + (i - 100) * 120 / 50;
+    if (i < 250) return 420 + noise(3);
+    return 420 - (i - 250) * 120 / 50;
+  default:
+    return i < 50 ? 300 : 332 + noise(11);
+  }
+}
+
+const uint16_t STREAM_LENGTH = 1024;
+const uint8_t BLOCK = 64;
+
+void report(const char* name, uint32_t cycles, uint32_t samples) {
+  Serial.print(name);
+  Serial.print(" ");
+  Serial.print((float)cycles * (1e9 / F_CPU) / samples, 1);
+  Serial.print(" ");
+  Serial.println((float)cycles / samples, 0);
+}
+
+void benchLogic(const char* name, SampleStream stream, uint8_t seed) {
+  BenchSensor sensor;
+  uint16_t block[BLOCK];
+  uint32_t cycles = 0;
+  noiseState = seed;
+  for (uint16_t i = 0; i < STREAM_LENGTH; i += BLOCK) {
+    // Stream generation is kept outside of the measured region.
+    for (uint8_t j = 0; j < BLOCK; j++) block[j] = nextSample(stream, i + j);
+    startCycleCounter();
+    for (uint8_t j = 0; j < BLOCK; j++) sensor.update((uint32_t)block[j] << 8);
+    cycles += readCycleCounter();
+  }
+  report(name, cycles, STREAM_LENGTH);
+}
+
+void benchMovingAverage() {
+  BenchSensor sensor;
+  uint16_t block[BLOCK];
+  uint32_t cycles = 0;
+  noiseState = 2;
+  sensor.update((uint32_t)300 << 8);
+  for (uint16_t i = 0; i < STREAM_LENGTH; i += BLOCK) {
+    for (uint8_t j = 0; j < BLOCK; j++) block[j] = nextSample(FLAT, i + j);
+    startCycleCounter();
+    for (uint8_t j = 0; j < BLOCK; j++) sensor.updateMovingAverage((uint32_t)block[j] << 8);
+    cycles += readCycleCounter();
+  }
+  report("filter.movingAverage", cycles, STREAM_LENGTH);
+}
+
+void benchAcquisition(uint8_t resolution, uint8_t dischargeDelayUs = 0, uint8_t dischargedInterval = 0,
+                      bool adaptiveJitter = false) {
+  BenchSensor sensor;
+  sensor.setResolution(resolution);
+  if (dischargeDelayUs) sensor.setDischargeDelayUs(dischargeDelayUs);
+  sensor.setDischargedReferenceInterval(dischargedInterval);
+  sensor.setAdaptiveJitter(adaptiveJitter);
+  uint16_t updates = resolution < 8 ? 256 >> resolution : 2;
+  srand(1);
+  startCycleCounter();
+  for (uint16_t i = 0; i < updates; i++) sensor.update();
+  uint32_t cycles = readCycleCounter();
+  char name[24];
+  if (dischargeDelayUs) snprintf(name, sizeof(name), "acquire.res%u.delay%u", resolution, dischargeDelayUs);
+  else if (dischargedInterval) snprintf(name, sizeof(name), "acquire.res%u.se%u", resolution, dischargedInterval);
+  else if (adaptiveJitter) snprintf(name, sizeof(name), "acquire.res%u.adaptive", resolution);
+  else snprintf(name, sizeof(name), "acquire.res%u", resolution);
+  report(name, cycles, updates);
+}
+
+void setup() {
+
+  Serial.begin(9600);
+  while (!Serial);
+
+  ProximitySensor::begin();
+
+  Serial.println("# case ns/sample avr_cycles/sample");
+
+  benchLogic("logic.flat", FLAT, 2);
+  benchLogic("logic.approach", APPROACH, 3);
+  benchLogic("logic.threshold", THRESHOLD, 4);
+  benchMovingAverage();
+
+  benchAcquisition(0);
+  benchAcquisition(4);
+  benchAcquisition(7);
+  benchAcquisition(10);
+  benchAcquisition(7, 4);
+  benchAcquisition(7, 0, 4);
+  benchAcquisition(7, 0, 0, true);
+
+  // Shortest S&H discharge delay that leaves this board's readings unbiased.
+  BenchSensor sensor;
+  uint8_t delayUs = sensor.calibrateDischargeDelay();
+  Serial.print("# calibrated discharge delay ");
+  Serial.print(delayUs);
+  Serial.println(" us");
+  benchAcquisition(7, delayUs);
+
+  // Release Timer1 for the application.
+  TIMSK1 = 0;
+  TCCR1B = 0;
+}
+
+void loop() {
+}
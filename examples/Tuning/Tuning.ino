@@ -0,0 +1,33 @@
+#include <ProximitySensor.h>
+#include <SensorConsole.h>
+#include <TAdcPinInput.h>
+
+// Uses PB4/ADC11/A8 as the reference pin and PB5/ADC12/A9 as the sensor pin.
+ProximitySensor sensor(&TAdcPinInput<11>::instance(),&TAdcPinInput<12>::instance());
+
+// Serves the host console (extras/host/console), e.g.:
+//   console --port /dev/ttyACM0 "get 0; set 0 touch 40; watch 0 5 100"
+// Settings changed from the console are lost on reset; copy the values
+// that work into setup().
+SensorConsole console(Serial, sensor);
+
+void setup() {
+
+  Serial.begin(9600);
+
+  // Called once in during setup. Configures ADC.
+  ProximitySensor::begin();
+
+  sensor.setProximityThreshold(5);
+  sensor.setTouchThreshold(15);
+
+}
+
+void loop() {
+
+  uint32_t sample = sensor.update();
+
+  // Handles console commands and sends telemetry; never waits for input.
+  console.poll(&sample);
+
+}
@@ -0,0 +1,98 @@
+#!/bin/sh
+#
+# Cost of each PROXIMITY_FEATURES combination (see ProximitySensor.h).
+#
+#   extras/features.sh [--fqbn FQBN] [--port PORT] [MASK...]
+#
+# For every feature mask (all 64 by default) the library is rebuilt with
+# -DPROXIMITY_FEATURES=MASK and the table lists:
+#
+#   flash, ram  the FeatureCost example built with arduino-cli for the
+#               Leonardo (ATmega32U4), if arduino-cli is installed
+#   cycles      CPU cycles per update(uint32_t) printed by FeatureCost on
+#               the board at PORT, if given (the sketch is uploaded)
+#   host_ns     host ns per update(uint32_t) on the approach stream from
+#               the host benchmark (extras/host/bench)
+#
+# Set ARDUINO_CLI to use an arduino-cli other than the one on PATH and CXX
+# for the host compiler.
+#
+
+set -e
+
+ARDUINO_CLI=${ARDUINO_CLI:-arduino-cli}
+CXX=${CXX:-g++}
+FQBN=arduino:avr:leonardo
+PORT=
+MASKS=
+
+while [ $# -gt 0 ]; do
+  case "$1" in
+    --fqbn) FQBN=$2; shift 2 ;;
+    --port) PORT=$2; shift 2 ;;
+    -*) echo "usage: $0 [--fqbn FQBN] [--port PORT] [MASK...]" >&2; exit 2 ;;
+    *) MASKS="$MASKS $1"; shift ;;
+  esac
+done
+
+[ -n "$MASKS" ] || MASKS=$(i=0; while [ $i -lt 64 ]; do printf '0x%02x ' $i; i=$((i + 1)); done)
+
+ARDUINO=
+if command -v "$ARDUINO_CLI" >/dev/null 2>&1; then
+  ARDUINO=yes
+else
+  echo "$0: $ARDUINO_CLI not found, flash and ram are not reported" >&2
+fi
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+HOST=$ROOT/extras/host
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Feature names in the order of their bits, abbreviated for the table.
+names() {
+  list=
+  bit=1
+  for name in sample state timeout debounce reseed stats; do
+    [ $(($1 & bit)) -ne 0 ] && list="$list${list:+,}$name"
+    bit=$((bit * 2))
+  done
+  echo "${list:--}"
+}
+
+# Host ns per update for mask $1.
+host_ns() {
+  "$CXX" -O2 -std=c++11 -I"$HOST/shim" -I"$HOST/common" -I"$ROOT/src" -DF_CPU=16000000UL \
+         -DPROXIMITY_FEATURES=$1 -o "$WORK/bench" "$HOST/bench/Bench.cpp" "$ROOT"/src/impl/*.cpp \
+         "$HOST/shim/HostAvr.cpp" "$HOST/common/Electrode.cpp" "$HOST/common/TextTrace.cpp" \
+         "$HOST/common/TraceFile.cpp" || { echo "?"; return; }
+  "$WORK/bench" --cases logic.approach | awk '$1 == "logic.approach" { print $2 }'
+}
+
+# "<flash> <ram> <cycles>" for mask $1.
+target() {
+  if [ -z "$ARDUINO" ]; then
+    echo "- - -"
+    return
+  fi
+  upload=
+  [ -n "$PORT" ] && upload="--upload --port $PORT"
+  output=$("$ARDUINO_CLI" compile --fqbn "$FQBN" --library "$ROOT" --build-path "$WORK/build" \
+           --build-property "compiler.cpp.extra_flags=-DPROXIMITY_FEATURES=$1" $upload \
+           "$ROOT/examples/FeatureCost" 2>&1) || { echo "? ? ?"; return; }
+  flash=$(echo "$output" | sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p')
+  ram=$(echo "$output" | sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p')
+  cycles=-
+  if [ -n "$PORT" ]; then
+    sleep 2
+    stty -F "$PORT" 9600 raw -echo
+    cycles=$(timeout 10 sed -n 's/^features .* cycles \([0-9]*\).*/\1/p; /^features/q' < "$PORT" || true)
+  fi
+  echo "${flash:-?} ${ram:-?} ${cycles:-?}"
+}
+
+printf '%-6s %-44s %8s %8s %8s %8s\n' mask features flash ram cycles host_ns
+for mask in $MASKS; do
+  set -- $(target $mask)
+  printf '%-6s %-44s %8s %8s %8s %8s\n' $mask "$(names $mask)" "$1" "$2" "$3" "$(host_ns $mask)"
+done
@@ -0,0 +1,611 @@
+/*
+ * Bench.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Host microbenchmark for the ProximitySensor filter, state machine and
+ * acquisition loop.
+ *
+ *   bench [--trace FILE] [--cases PREFIX] [--baseline FILE [--tolerance PCT]] [--write-baseline FILE]
+ *
+ * --trace takes a trace file (see TraceFile.h) or a SensorTrace capture and
+ * adds logic.trace, which replays the samples of its first source, and for
+ * trace files trace.decode, which times decoding every chunk.
+ *
+ * --cases runs only the cases whose names start with PREFIX, e.g. "logic.".
+ *
+ * Builds with a mains hum filter run only the acquisition cases and add the
+ * variant to their names, e.g. acquire.res7.sync. --write-baseline replaces
+ * the cases run in FILE and keeps the others, so one baseline holds every
+ * build.
+ *
+ * Each case reports host nanoseconds per sample and modeled AVR cycles per
+ * sample: for the cases that go through the ADC from the host clock (see
+ * HostAvr.h for what it covers), and for the logic and filter cases from the
+ * path model in LogicCycles. The SensorBenchmark example prints the same case
+ * names with cycle counts measured on the target.
+ */
+
+#include <HostAvr.h>
+#include <HostSensor.h>
+#include <Electrode.h>
+#include <TextTrace.h>
+#include <TraceFile.h>
+#include <TAdcPinInput.h>
+#include <ProximitySensorArray.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+const uint32_t SAMPLE_PERIOD_MS = 10;
+const int RUNS = 5;
+const double MIN_RUN_SECONDS = 0.05;
+
+struct Result {
+  std::string name;
+  double nsPerSample;
+  double cyclesPerSample; // < 0 if not modeled
+};
+
+typedef std::chrono::steady_clock Clock;
+
+const char* s_casePrefix = "";
+
+// Case name suffix of builds with a mains hum filter (see
+// PROXIMITY_HUM_FILTER).
+#if PROXIMITY_HUM_FILTER == PROXIMITY_HUM_FILTER_SYNC
+const char* const HUM_VARIANT = ".sync";
+#elif PROXIMITY_HUM_FILTER == PROXIMITY_HUM_FILTER_COMB
+const char* const HUM_VARIANT = ".comb";
+#else
+const char* const HUM_VARIANT = "";
+#endif
+
+bool selected(const char* name) {
+  return strncmp(name, s_casePrefix, strlen(s_casePrefix)) == 0;
+}
+
+double elapsedNs(Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+HostSensor* newSensor() {
+  return new HostSensor(&TAdcPinInput<11>::instance(), &TAdcPinInput<12>::instance());
+}
+
+/**
+ * Times repeated passes of a case and keeps the fastest run, which is
+ * the figure least disturbed by other activity on the host.
+ */
+template<typename Pass> double bestNsPerSample(Pass& pass) {
+  double best = 0;
+  for (int run = 0; run < RUNS; run++) {
+    uint64_t count = 0;
+    Clock::time_point start = Clock::now();
+    do {
+      count += pass();
+    } while (elapsedNs(start) < MIN_RUN_SECONDS * 1e9);
+    double ns = elapsedNs(start) / count;
+    if (run == 0 || ns < best) best = ns;
+  }
+  return best;
+}
+
+/**
+ * Runs the state machine over a sample stream, advancing the clock
+ * by a fixed sample period.
+ */
+struct LogicPass {
+  HostSensor* sensor;
+  const std::vector<uint32_t>* samples;
+  uint32_t timeMs;
+  uint32_t sink;
+  size_t operator()() {
+    for (size_t i = 0; i < samples->size(); i++) {
+      timeMs += SAMPLE_PERIOD_MS;
+      host::setMillis(timeMs);
+      sink += sensor->update((*samples)[i] << 8);
+    }
+    return samples->size();
+  }
+};
+
+/**
+ * Cycle model of update(uint32_t) and updateMovingAverage(), which the
+ * host clock does not see. Costs are estimated from the ATmega32U4
+ * instruction timings for the code avr-gcc emits at -Os: 32-bit loads,
+ * stores and compares at one or two cycles a byte, and 32-bit products
+ * through libgcc's __mulsi3 at about 30 cycles with the call. The path
+ * taken is read from the state and debounce flag before and after each
+ * update, following TRANSITIONS in ProximitySensor.cpp. Sensors have no
+ * state callback.
+ */
+namespace LogicCycles {
+
+// Call, return, register saves and the pending reseed test.
+const uint32_t ENTRY = 36;
+// A pending reseed: store the sample as the average and clear the flag.
+const uint32_t RESEED = 14;
+// Four (threshold * average) >> 8 products and the adds between them.
+const uint32_t THRESHOLDS = 4 * 38;
+// Four 32-bit compares for the band and the release bit, and the column.
+const uint32_t BAND = 30;
+// currentTimeMs(): paced flag test and millis() with interrupts masked.
+const uint32_t NOW = 30;
+// One table entry: address, LPM, action flag tests and next state test.
+const uint32_t TRANSITION = 16;
+const uint32_t DEBOUNCE_START = 14;
+const uint32_t DEBOUNCE_CHECK = 22;
+const uint32_t TIMEOUT_CHECK = 30;
+const uint32_t CLEAR_DELAY = 4;
+// updateMovingAverage(): call, 32-bit difference, product, arithmetic
+// shift by 8, add and store.
+const uint32_t MOVING_AVERAGE = 74;
+const uint32_t SNAP = 8;
+// Start time and state stores and the callback pointer test.
+const uint32_t STATE_CHANGE = 16;
+
+/**
+ * Cycles of one update(uint32_t) with the given sample, in counts, that
+ * left the sensor as it is now.
+ */
+uint32_t update(const HostSensor& sensor, uint32_t sample, ProximitySensor::State before,
+                bool delayingBefore, uint32_t averageBefore, bool reseedPending) {
+  if (reseedPending) return ENTRY + RESEED;
+  const ProximitySensor::State IDLE = ProximitySensor::IDLE;
+  const ProximitySensor::State PROXIMITY = ProximitySensor::PROXIMITY;
+  const ProximitySensor::State TOUCH = ProximitySensor::TOUCH;
+  ProximitySensor::State after = sensor.getState();
+  // Snapping replaces the average with the sample; adapting only moves
+  // it a fraction of the way.
+  bool snapped = sensor.getMovingAverage() == sample && averageBefore != sample;
+  uint32_t cycles = ENTRY + THRESHOLDS + BAND + NOW + TRANSITION;
+  if (before == IDLE) {
+    if (after == IDLE) {
+      if (sensor.isDelaying()) return cycles + (delayingBefore ? DEBOUNCE_CHECK : DEBOUNCE_START);
+      return cycles + CLEAR_DELAY + (snapped ? SNAP : MOVING_AVERAGE);
+    }
+    // Debounce passed; PROXIMITY times out or enters TOUCH, which times out.
+    cycles += DEBOUNCE_CHECK + CLEAR_DELAY + STATE_CHANGE + TRANSITION;
+    if (after == TOUCH) cycles += STATE_CHANGE + TRANSITION;
+    return cycles + TIMEOUT_CHECK;
+  }
+  if (after == before) return cycles + TIMEOUT_CHECK;
+  if (before == PROXIMITY && after == TOUCH) return cycles + STATE_CHANGE + TRANSITION + TIMEOUT_CHECK;
+  if (after == PROXIMITY) return cycles + STATE_CHANGE;
+  // Back to IDLE by timeout (snap) or by dropping below a threshold (adapt).
+  return cycles + STATE_CHANGE + (snapped ? TIMEOUT_CHECK + SNAP : MOVING_AVERAGE);
+}
+
+}
+
+/**
+ * Modeled AVR cycles per sample of a stream through a new sensor.
+ */
+double logicCycles(const std::vector<uint32_t>& samples) {
+  host::reset();
+  HostSensor* sensor = newSensor();
+  uint64_t cycles = 0;
+  uint32_t timeMs = 0;
+  for (size_t i = 0; i < samples.size(); i++) {
+    ProximitySensor::State before = sensor->getState();
+    bool delaying = sensor->isDelaying();
+    uint32_t average = sensor->getMovingAverage();
+    timeMs += SAMPLE_PERIOD_MS;
+    host::setMillis(timeMs);
+    sensor->update(samples[i] << 8);
+    cycles += LogicCycles::update(*sensor, samples[i], before, delaying, average, i == 0);
+  }
+  delete sensor;
+  return (double)cycles / samples.size();
+}
+
+Result runLogic(const char* name, const std::vector<uint32_t>& samples) {
+  host::reset();
+  HostSensor* sensor = newSensor();
+  LogicPass pass = { sensor, &samples, 0, 0 };
+  double ns = bestNsPerSample(pass);
+  delete sensor;
+  Result result = { name, ns, logicCycles(samples) };
+  return result;
+}
+
+struct MovingAveragePass {
+  HostSensor* sensor;
+  const std::vector<uint32_t>* samples;
+  uint32_t sink;
+  size_t operator()() {
+    for (size_t i = 0; i < samples->size(); i++) {
+      sink += sensor->updateMovingAverage((*samples)[i] << 8);
+    }
+    return samples->size();
+  }
+};
+
+Result runMovingAverage(const std::vector<uint32_t>& samples) {
+  host::reset();
+  HostSensor* sensor = newSensor();
+  sensor->update(samples[0] << 8);
+  MovingAveragePass pass = { sensor, &samples, 0 };
+  double ns = bestNsPerSample(pass);
+  delete sensor;
+  Result result = { "filter.movingAverage", ns, (double)LogicCycles::MOVING_AVERAGE };
+  return result;
+}
+
+struct DecodePass {
+  const TraceReader* reader;
+  TraceColumns columns;
+  size_t operator()() {
+    size_t records = 0;
+    for (size_t i = 0; i < reader->getChunkCount(); i++) {
+      reader->readChunk(i, columns);
+      records += columns.size();
+    }
+    return records;
+  }
+};
+
+Result runDecode(const TraceReader& reader) {
+  DecodePass pass = { &reader, TraceColumns() };
+  Result result = { "trace.decode", bestNsPerSample(pass), -1 };
+  return result;
+}
+
+class FlatElectrode : public Electrode {
+public:
+  FlatElectrode() : Electrode(&PORTB, PB4, TAdcPinInput<12>::instance().getMuxIndex()) {}
+  double level(double) { return 300; }
+};
+
+/**
+ * Runs the complete update() path, including acquisition through the
+ * host ADC model. Every pass reseeds rand() so that the random charge
+ * delays, and with them the modeled cycle count, repeat exactly.
+ */
+struct AcquisitionPass {
+  HostSensor* sensor;
+  size_t updates;
+  uint64_t cycles;
+  uint32_t sink;
+  size_t operator()() {
+    srand(1);
+    uint64_t startCycles = host::getCycles();
+    for (size_t i = 0; i < updates; i++) {
+      sink += sensor->update();
+    }
+    cycles = host::getCycles() - startCycles;
+    return updates;
+  }
+};
+
+Result runAcquisition(uint8_t resolution, uint8_t dischargeDelayUs = 0, uint8_t dischargedInterval = 0,
+                      bool adaptiveJitter = false) {
+  host::reset();
+  FlatElectrode electrode;
+  electrode.attach();
+  ProximitySensor::begin();
+  HostSensor* sensor = newSensor();
+  sensor->setResolution(resolution);
+  if (dischargeDelayUs) sensor->setDischargeDelayUs(dischargeDelayUs);
+  sensor->setDischargedReferenceInterval(dischargedInterval);
+  sensor->setAdaptiveJitter(adaptiveJitter);
+  AcquisitionPass pass = { sensor, (size_t)(resolution < 8 ? 256 >> resolution : 2), 0, 0 };
+  double ns = bestNsPerSample(pass);
+  double cycles = (double)pass.cycles / pass.updates;
+  delete sensor;
+  char name[32];
+  if (dischargeDelayUs) snprintf(name, sizeof(name), "acquire.res%u.delay%u", resolution, dischargeDelayUs);
+  else if (dischargedInterval) snprintf(name, sizeof(name), "acquire.res%u.se%u", resolution, dischargedInterval);
+  else if (adaptiveJitter) snprintf(name, sizeof(name), "acquire.res%u.adaptive", resolution);
+  else snprintf(name, sizeof(name), "acquire.res%u", resolution);
+  Result result = { name, ns, cycles };
+  return result;
+}
+
+/**
+ * Small LCG shared with the SensorBenchmark sketch so that both produce
+ * identical synthetic streams.
+ */
+uint16_t s_noiseState;
+
+uint8_t noise(uint8_t span) {
+  s_noiseState = s_noiseState * 25173 + 13849;
+  return (s_noiseState >> 8) % span;
+}
+
+/**
+ * Raw block acquisition of 128 pairs, reported per block so that it
+ * compares directly with acquire.res7.
+ */
+struct BlockPass {
+  HostSensor* sensor;
+  ProximitySensor::SamplePair block[128];
+  uint64_t cycles;
+  size_t operator()() {
+    srand(1);
+    uint64_t startCycles = host::getCycles();
+    for (int i = 0; i < 2; i++) {
+      sensor->acquire(block, 128);
+    }
+    cycles = host::getCycles() - startCycles;
+    return 2;
+  }
+};
+
+Result runBlockAcquisition() {
+  host::reset();
+  FlatElectrode electrode;
+  electrode.attach();
+  ProximitySensor::begin();
+  HostSensor* sensor = newSensor();
+  BlockPass* pass = new BlockPass();
+  pass->sensor = sensor;
+  double ns = bestNsPerSample(*pass);
+  double cycles = (double)pass->cycles / 2;
+  delete pass;
+  delete sensor;
+  Result result = { "acquire.block128", ns, cycles };
+  return result;
+}
+
+/**
+ * Eight sensors sharing one reference pin at resolution 7, updated one
+ * after another and as an array. Reported per update of all eight.
+ */
+struct ArrayPass {
+  ProximitySensor** sensors;
+  ProximitySensorArray* array;
+  uint64_t cycles;
+  size_t operator()() {
+    srand(1);
+    uint64_t startCycles = host::getCycles();
+    if (array) {
+      array->update();
+    }
+    else {
+      for (int i = 0; i < 8; i++) sensors[i]->update();
+    }
+    cycles = host::getCycles() - startCycles;
+    return 1;
+  }
+};
+
+Result runArrayAcquisition(bool asArray) {
+  host::reset();
+  FlatElectrode electrode;
+  electrode.attach();
+  ProximitySensor::begin();
+  AdcPinInput* reference = &TAdcPinInput<11>::instance();
+  ProximitySensor* sensors[8] = {
+    new HostSensor(reference, &TAdcPinInput<0>::instance()),
+    new HostSensor(reference, &TAdcPinInput<1>::instance()),
+    new HostSensor(reference, &TAdcPinInput<6>::instance()),
+    new HostSensor(reference, &TAdcPinInput<7>::instance()),
+    new HostSensor(reference, &TAdcPinInput<8>::instance()),
+    new HostSensor(reference, &TAdcPinInput<9>::instance()),
+    new HostSensor(reference, &TAdcPinInput<10>::instance()),
+    new HostSensor(reference, &TAdcPinInput<12>::instance())
+  };
+  ProximitySensorArray array(sensors, 8);
+  array.setResolution(7);
+  ArrayPass pass = { sensors, asArray ? &array : 0, 0 };
+  double ns = bestNsPerSample(pass);
+  for (int i = 0; i < 8; i++) delete sensors[i];
+  Result result = { asArray ? "array8.res7" : "sequential8.res7", ns, (double)pass.cycles };
+  return result;
+}
+
+std::vector<uint32_t> flatStream() {
+  std::vector<uint32_t> samples;
+  s_noiseState = 2;
+  for (int i = 0; i < 1024; i++) {
+    samples.push_back(298 + noise(5));
+  }
+  return samples;
+}
+
+/**
+ * Idle, slow approach, touch, release. Levels are chosen against the
+ * default thresholds (proximity at +12.5%, touch at +25% of the average).
+ */
+std::vector<uint32_t> approachStream() {
+  std::vector<uint32_t> samples;
+  s_noiseState = 3;
+  for (int cycle = 0; cycle < 4; cycle++) {
+    for (int i = 0; i < 100; i++) samples.push_back(300 + noise(3));
+    for (int i = 0; i < 50; i++) samples.push_back(300 + i * 120 / 50);
+    for (int i = 0; i < 100; i++) samples.push_back(420 + noise(3));
+    for (int i = 0; i < 50; i++) samples.push_back(420 - i * 120 / 50);
+  }
+  return samples;
+}
+
+/**
+ * Samples dithering across the proximity threshold to exercise the
+ * debounce path.
+ */
+std::vector<uint32_t> thresholdStream() {
+  std::vector<uint32_t> samples;
+  s_noiseState = 4;
+  for (int i = 0; i < 50; i++) samples.push_back(300);
+  for (int i = 0; i < 974; i++) samples.push_back(332 + noise(11));
+  return samples;
+}
+
+bool readBaseline(const char* path, std::vector<Result>& baseline) {
+  FILE* file = fopen(path, "r");
+  if (!file) return false;
+  char line[128];
+  while (fgets(line, sizeof(line), file)) {
+    if (line[0] == '#') continue;
+    char name[64];
+    char cycles[32];
+    double ns;
+    if (sscanf(line, "%63s %lf %31s", name, &ns, cycles) != 3) continue;
+    Result result = { name, ns, strcmp(cycles, "-") == 0 ? -1 : atof(cycles) };
+    baseline.push_back(result);
+  }
+  fclose(file);
+  return true;
+}
+
+const Result* findResult(const std::vector<Result>& results, const std::string& name) {
+  for (size_t i = 0; i < results.size(); i++) {
+    if (results[i].name == name) return &results[i];
+  }
+  return 0;
+}
+
+void printResults(FILE* file, const std::vector<Result>& results) {
+  fprintf(file, "# %-26s%9s%19s\n", "case", "ns/sample", "avr_cycles/sample");
+  for (size_t i = 0; i < results.size(); i++) {
+    if (results[i].cyclesPerSample < 0) {
+      fprintf(file, "%-28s%9.1f%19s\n", results[i].name.c_str(), results[i].nsPerSample, "-");
+    }
+    else {
+      fprintf(file, "%-28s%9.1f%19.0f\n", results[i].name.c_str(), results[i].nsPerSample, results[i].cyclesPerSample);
+    }
+  }
+}
+
+/**
+ * Modeled cycle counts are deterministic and must not grow at all.
+ * Host timings are noisy and are only flagged past the tolerance.
+ */
+int compareBaseline(const std::vector<Result>& results, const std::vector<Result>& baseline, double tolerancePct) {
+  int regressions = 0;
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result* pBase = findResult(baseline, results[i].name);
+    if (!pBase) {
+      printf("new      %s\n", results[i].name.c_str());
+      continue;
+    }
+    const Result& base = *pBase;
+    double nsChange = 100.0 * (results[i].nsPerSample - base.nsPerSample) / base.nsPerSample;
+    bool nsRegressed = nsChange > tolerancePct;
+    bool cyclesRegressed = results[i].cyclesPerSample >= 0 && base.cyclesPerSample >= 0
+                           && results[i].cyclesPerSample > base.cyclesPerSample + 0.5;
+    printf("%-8s %-24s ns %+7.1f%%", nsRegressed || cyclesRegressed ? "REGRESS" : "ok", results[i].name.c_str(), nsChange);
+    if (results[i].cyclesPerSample >= 0 && base.cyclesPerSample >= 0) {
+      printf("  cycles %+7.1f%%", 100.0 * (results[i].cyclesPerSample - base.cyclesPerSample) / base.cyclesPerSample);
+    }
+    printf("\n");
+    if (nsRegressed || cyclesRegressed) regressions++;
+  }
+  return regressions;
+}
+
+void usage() {
+  fprintf(stderr, "usage: bench [--trace FILE] [--cases PREFIX] [--baseline FILE [--tolerance PCT]] "
+                  "[--write-baseline FILE]\n");
+}
+
+}
+
+int main(int argc, char** argv) {
+
+  const char* tracePath = 0;
+  const char* baselinePath = 0;
+  const char* writeBaselinePath = 0;
+  double tolerancePct = 25;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) tracePath = argv[++i];
+    else if (strcmp(argv[i], "--cases") == 0 && i + 1 < argc) s_casePrefix = argv[++i];
+    else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) baselinePath = argv[++i];
+    else if (strcmp(argv[i], "--write-baseline") == 0 && i + 1 < argc) writeBaselinePath = argv[++i];
+    else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) tolerancePct = atof(argv[++i]);
+    else {
+      usage();
+      return 2;
+    }
+  }
+
+  std::vector<Result> results;
+
+  // The logic, filter and trace cases do not depend on the hum filter.
+  if (!*HUM_VARIANT) {
+    if (selected("logic.flat")) results.push_back(runLogic("logic.flat", flatStream()));
+    if (selected("logic.approach")) results.push_back(runLogic("logic.approach", approachStream()));
+    if (selected("logic.threshold")) results.push_back(runLogic("logic.threshold", thresholdStream()));
+    if (selected("filter.movingAverage")) results.push_back(runMovingAverage(flatStream()));
+
+    if (tracePath) {
+      std::vector<TraceRecord> records;
+      if (!readTrace(tracePath, SAMPLE_PERIOD_MS, records)) {
+        fprintf(stderr, "bench: no samples in %s\n", tracePath);
+        return 2;
+      }
+      std::vector<uint32_t> samples;
+      for (size_t i = 0; i < records.size(); i++) {
+        if (records[i].device == records[0].device && records[i].channel == records[0].channel) {
+          samples.push_back(records[i].sample);
+        }
+      }
+      if (selected("logic.trace")) results.push_back(runLogic("logic.trace", samples));
+      TraceReader reader;
+      if (selected("trace.decode") && reader.open(tracePath) && reader.getRecordCount()) {
+        results.push_back(runDecode(reader));
+      }
+    }
+  }
+
+  static const uint8_t resolutions[] = { 0, 4, 7, 10 };
+  for (size_t i = 0; i < sizeof(resolutions); i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "acquire.res%u", resolutions[i]);
+    if (selected(name)) results.push_back(runAcquisition(resolutions[i]));
+  }
+  if (selected("acquire.res7.delay4")) results.push_back(runAcquisition(7, 4));
+  if (selected("acquire.res7.se4")) results.push_back(runAcquisition(7, 0, 4));
+  if (selected("acquire.res7.adaptive")) results.push_back(runAcquisition(7, 0, 0, true));
+  if (selected("acquire.block128") && !*HUM_VARIANT) results.push_back(runBlockAcquisition());
+  if (selected("sequential8.res7")) results.push_back(runArrayAcquisition(false));
+  if (selected("array8.res7")) results.push_back(runArrayAcquisition(true));
+
+  for (size_t i = 0; i < results.size(); i++) {
+    results[i].name += HUM_VARIANT;
+  }
+
+  printResults(stdout, results);
+
+  if (writeBaselinePath) {
+    // Cases stored in the file that were not run, e.g. those of other hum
+    // filter variants, are kept.
+    std::vector<Result> stored;
+    readBaseline(writeBaselinePath, stored);
+    for (size_t i = 0; i < results.size(); i++) {
+      size_t j = 0;
+      while (j < stored.size() && stored[j].name != results[i].name) j++;
+      if (j < stored.size()) stored[j] = results[i];
+      else stored.push_back(results[i]);
+    }
+    FILE* file = fopen(writeBaselinePath, "w");
+    if (!file) {
+      fprintf(stderr, "bench: cannot write %s\n", writeBaselinePath);
+      return 2;
+    }
+    printResults(file, stored);
+    fclose(file);
+  }
+
+  if (baselinePath) {
+    std::vector<Result> baseline;
+    if (!readBaseline(baselinePath, baseline)) {
+      fprintf(stderr, "bench: cannot read %s\n", baselinePath);
+      return 2;
+    }
+    printf("\n");
+    if (compareBaseline(results, baseline, tolerancePct) > 0) return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * Electrode.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <Electrode.h>
+#include <HostAvr.h>
+#include <Arduino.h>
+
+Electrode::Electrode(volatile uint8_t* pReferencePort, uint8_t referenceBit, uint8_t sensorMux)
+: m_pReferencePort(pReferencePort)
+, m_referenceBit(referenceBit)
+, m_sensorMux(sensorMux)
+, m_commonMode(512)
+, m_fault(NO_FAULT)
+, m_pNext(0)
+{
+}
+
+Electrode::~Electrode() {
+}
+
+void Electrode::attach() {
+  host::setAdcSource(&Electrode::source, this);
+}
+
+uint16_t Electrode::convert(uint8_t muxIndex) {
+  if (muxIndex != m_sensorMux) {
+    if (m_pNext) return m_pNext->convert(muxIndex);
+    // Reference pin, ground or an unmodeled channel.
+    return 0;
+  }
+  if (m_fault == SHORT_GROUND) return 0;
+  if (m_fault == SHORT_RAIL) return 1023;
+  bool charged = !(*m_pReferencePort & _BV(m_referenceBit));
+  if (m_fault == SATURATED && charged) return 1023;
+  double seconds = (double)host::getCycles() / F_CPU;
+  double half = m_fault == OPEN ? 0 : level(seconds) / 2.0;
+  double value = charged
+               ? m_commonMode + half  // S&H grounded, electrode charged
+               : m_commonMode - half; // S&H precharged high, electrode discharged
+  value += coupling(seconds);
+  if (value < 0) return 0;
+  if (value > 1023) return 1023;
+  return (uint16_t)(value + 0.5);
+}
+
+uint16_t Electrode::source(uint8_t muxIndex, void* data) {
+  return static_cast<Electrode*>(data)->convert(muxIndex);
+}
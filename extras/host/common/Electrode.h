@@ -0,0 +1,93 @@
+/*
+ * Electrode.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef ELECTRODE_H_
+#define ELECTRODE_H_
+
+#include <stdint.h>
+
+/**
+ * Host model of a sensor electrode and its reference pin as seen by the ADC.
+ *
+ * The sensing sequence in ProximitySensor::update() converts the sensor pin
+ * twice per sample pair: once after the S&H cap has been precharged through
+ * the reference pin ("discharged" half) and once after the S&H cap has been
+ * grounded through the reference pin while the electrode was charged
+ * ("charged" half). The model tells the halves apart from the level the
+ * reference pin is driving and returns readings whose difference equals the
+ * signal level reported by level().
+ */
+class Electrode {
+public:
+
+  /**
+   * Wiring faults that diagnose() is meant to detect.
+   */
+  enum Fault {
+    NO_FAULT,
+    OPEN,         // no electrode on the pin: both halves read the common mode
+    SHORT_GROUND, // pin shorted to ground: every reading is 0
+    SHORT_RAIL,   // pin shorted to VCC: every reading is 1023
+    SATURATED     // coupling too large for the ADC: the charged half reads 1023
+  };
+
+  Electrode(volatile uint8_t* pReferencePort, uint8_t referenceBit, uint8_t sensorMux);
+
+  virtual ~Electrode();
+
+  /**
+   * Returns the charged-discharged difference, in ADC counts, that the
+   * electrode produces at the given simulated time.
+   */
+  virtual double level(double seconds) = 0;
+
+  /**
+   * Returns interference, in ADC counts, coupled onto the sensor pin at
+   * the given simulated time. It shifts both halves of a pair equally, so
+   * it cancels in the difference unless it changes between conversions.
+   */
+  virtual double coupling(double seconds) { return 0; }
+
+  /**
+   * Installs this electrode as the source for host ADC conversions.
+   */
+  void attach();
+
+  /**
+   * Common-mode level around which the charged and discharged readings sit.
+   */
+  void setCommonMode(uint16_t counts) { m_commonMode = counts; }
+
+  /**
+   * Applies a wiring fault to the readings, or removes it with NO_FAULT.
+   */
+  void setFault(Fault fault) { m_fault = fault; }
+
+  Fault getFault() const { return m_fault; }
+
+  /**
+   * Answers conversions of channels other than this electrode's from
+   * pNext, so that several electrodes can share the ADC. Only the first
+   * electrode of the chain is attached.
+   */
+  void chain(Electrode* pNext) { m_pNext = pNext; }
+
+  uint16_t convert(uint8_t muxIndex);
+
+private:
+
+  static uint16_t source(uint8_t muxIndex, void* data);
+
+  volatile uint8_t* m_pReferencePort;
+  uint8_t m_referenceBit;
+  uint8_t m_sensorMux;
+  uint16_t m_commonMode;
+  Fault m_fault;
+  Electrode* m_pNext;
+
+};
+
+#endif /* ELECTRODE_H_ */
@@ -0,0 +1,28 @@
+/*
+ * HostSensor.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HOSTSENSOR_H_
+#define HOSTSENSOR_H_
+
+#include <ProximitySensor.h>
+
+/**
+ * Exposes the protected filter and state machine entry points of
+ * ProximitySensor to the host tools so that they can be driven
+ * directly with recorded or synthetic samples.
+ */
+class HostSensor : public ProximitySensor {
+public:
+
+  HostSensor(AdcPinInput* pReferencePin, AdcPinInput* pSensorPin)
+  : ProximitySensor(pReferencePin, pSensorPin) {}
+
+  using ProximitySensor::update;
+  using ProximitySensor::updateMovingAverage;
+
+};
+
+#endif /* HOSTSENSOR_H_ */
@@ -0,0 +1,68 @@
+/*
+ * LoopbackStream.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef LOOPBACKSTREAM_H_
+#define LOOPBACKSTREAM_H_
+
+#include <Stream.h>
+
+#include <deque>
+
+/**
+ * One end of an in-memory serial line. Bytes written to one end of a
+ * connected pair are read from the other. Each end buffers at most
+ * capacity received bytes, like a serial driver, and availableForWrite()
+ * reports the room left at the peer, so a writer that ignores it loses
+ * bytes the way it would on a full port.
+ */
+class LoopbackStream : public Stream {
+public:
+
+  explicit LoopbackStream(size_t capacity = 64)
+  : m_pPeer(0)
+  , m_capacity(capacity) {}
+
+  void connect(LoopbackStream& peer) {
+    m_pPeer = &peer;
+    peer.m_pPeer = this;
+  }
+
+  size_t write(uint8_t byte) {
+    if (!m_pPeer || m_pPeer->m_received.size() >= m_pPeer->m_capacity) return 0;
+    m_pPeer->m_received.push_back(byte);
+    return 1;
+  }
+
+  using Print::write;
+
+  int availableForWrite() {
+    return m_pPeer ? (int)(m_pPeer->m_capacity - m_pPeer->m_received.size()) : 0;
+  }
+
+  int available() {
+    return (int)m_received.size();
+  }
+
+  int read() {
+    if (m_received.empty()) return -1;
+    uint8_t byte = m_received.front();
+    m_received.pop_front();
+    return byte;
+  }
+
+  int peek() {
+    return m_received.empty() ? -1 : m_received.front();
+  }
+
+private:
+
+  LoopbackStream* m_pPeer;
+  size_t m_capacity;
+  std::deque<uint8_t> m_received;
+
+};
+
+#endif /* LOOPBACKSTREAM_H_ */
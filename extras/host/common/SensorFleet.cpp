@@ -0,0 +1,263 @@
+/*
+ * SensorFleet.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <SensorFleet.h>
+#include <HostSensor.h>
+#include <TAdcPinInput.h>
+
+#include <thread>
+
+namespace {
+
+/**
+ * All ones if the condition holds, otherwise zero.
+ */
+inline uint32_t maskOf(bool condition) {
+  return -(uint32_t)condition;
+}
+
+inline uint32_t select(uint32_t mask, uint32_t a, uint32_t b) {
+  return (mask & a) | (~mask & b);
+}
+
+}
+
+// On x86 the kernel is also built for AVX2, which handles eight sensors
+// per instruction instead of four, and the loader picks that build when
+// the CPU supports it.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define FLEET_KERNEL_CLONES __attribute__((target_clones("avx2", "default")))
+#endif
+#endif
+#ifndef FLEET_KERNEL_CLONES
+#define FLEET_KERNEL_CLONES
+#endif
+
+SensorFleet::Config SensorFleet::configOf(const ProximitySensor& sensor) {
+  Config config;
+  config.adaptationRate = sensor.getFilterAdaptationRate();
+  config.reseedThreshold = sensor.getFilterReseedThreshold();
+  config.proximityThreshold = sensor.getProximityThreshold();
+  config.touchThreshold = sensor.getTouchThreshold();
+  config.releaseThreshold = sensor.getReleaseThreshold();
+  config.delayMs = sensor.getDelayMs();
+  config.proximityTimeoutMs = sensor.getProximityTimeoutMs();
+  config.touchTimeoutMs = sensor.getTouchTimeoutMs();
+  return config;
+}
+
+SensorFleet::SensorFleet(size_t count, uint32_t startMs)
+: m_count(count)
+, m_adaptationRate(count)
+, m_reseedThreshold(count)
+, m_proximityThreshold(count)
+, m_touchThreshold(count)
+, m_releaseThreshold(count)
+, m_delayMs(count)
+, m_proximityTimeoutMs(count)
+, m_touchTimeoutMs(count)
+, m_average(count, 0)
+, m_state(count, ProximitySensor::IDLE)
+, m_reseed(count, ~0U)
+, m_delayStartMs(count, 0)
+, m_delaying(count, 0)
+, m_idleStartMs(count, startMs)
+, m_proximityStartMs(count, 0)
+, m_touchStartMs(count, 0)
+, m_proximityEvents(count, 0)
+, m_touchEvents(count, 0)
+, m_timeouts(count, 0)
+{
+  HostSensor defaults(&TAdcPinInput<11>::instance(), &TAdcPinInput<12>::instance());
+  configureAll(configOf(defaults));
+}
+
+void SensorFleet::reset(size_t sensor, uint32_t startMs) {
+  m_average[sensor] = 0;
+  m_state[sensor] = ProximitySensor::IDLE;
+  m_reseed[sensor] = ~0U;
+  m_delayStartMs[sensor] = 0;
+  m_delaying[sensor] = 0;
+  m_idleStartMs[sensor] = startMs;
+  m_proximityStartMs[sensor] = 0;
+  m_touchStartMs[sensor] = 0;
+}
+
+void SensorFleet::configure(size_t sensor, const Config& config) {
+  m_adaptationRate[sensor] = config.adaptationRate;
+  m_reseedThreshold[sensor] = config.reseedThreshold;
+  m_proximityThreshold[sensor] = config.proximityThreshold;
+  m_touchThreshold[sensor] = config.touchThreshold;
+  m_releaseThreshold[sensor] = config.releaseThreshold;
+  m_delayMs[sensor] = config.delayMs;
+  m_proximityTimeoutMs[sensor] = config.proximityTimeoutMs;
+  m_touchTimeoutMs[sensor] = config.touchTimeoutMs;
+}
+
+void SensorFleet::configureAll(const Config& config) {
+  for (size_t i = 0; i < m_count; i++) configure(i, config);
+}
+
+FLEET_KERNEL_CLONES
+void SensorFleet::update(const uint32_t* pSamples, const uint32_t* pTimesMs, size_t begin, size_t end) {
+
+  const uint32_t* __restrict samples = pSamples;
+  const uint32_t* __restrict times = pTimesMs;
+
+  const uint32_t* __restrict adaptationRate = m_adaptationRate.data();
+  const uint32_t* __restrict reseedThreshold = m_reseedThreshold.data();
+  const uint32_t* __restrict proximityThreshold = m_proximityThreshold.data();
+  const uint32_t* __restrict touchThreshold = m_touchThreshold.data();
+  const uint32_t* __restrict releaseThreshold = m_releaseThreshold.data();
+  const uint32_t* __restrict delayMs = m_delayMs.data();
+  const uint32_t* __restrict proximityTimeoutMs = m_proximityTimeoutMs.data();
+  const uint32_t* __restrict touchTimeoutMs = m_touchTimeoutMs.data();
+
+  uint32_t* __restrict averages = m_average.data();
+  uint32_t* __restrict states = m_state.data();
+  uint32_t* __restrict reseeds = m_reseed.data();
+  uint32_t* __restrict delayStarts = m_delayStartMs.data();
+  uint32_t* __restrict delayings = m_delaying.data();
+  uint32_t* __restrict idleStarts = m_idleStartMs.data();
+  uint32_t* __restrict proximityStarts = m_proximityStartMs.data();
+  uint32_t* __restrict touchStarts = m_touchStartMs.data();
+  uint32_t* __restrict proximityEvents = m_proximityEvents.data();
+  uint32_t* __restrict touchEvents = m_touchEvents.data();
+  uint32_t* __restrict timeouts = m_timeouts.data();
+
+  const uint32_t IDLE = ProximitySensor::IDLE;
+  const uint32_t PROXIMITY = ProximitySensor::PROXIMITY;
+  const uint32_t TOUCH = ProximitySensor::TOUCH;
+
+  // Lanes are independent and the arrays never overlap; without this GCC
+  // gives up on the run-time alias checks for twenty arrays.
+#pragma GCC ivdep
+  for (size_t i = begin; i < end; i++) {
+
+    const uint32_t sample = samples[i];
+    const uint32_t now = times[i];
+    const uint32_t average = averages[i];
+    const uint32_t state = states[i];
+    const uint32_t delayStart = delayStarts[i];
+
+    // Thresholds from the average at entry, as in update(uint32_t).
+    const uint32_t reseedLevel = average - ((reseedThreshold[i] * average) >> 8);
+    const uint32_t proximityLevel = average + ((proximityThreshold[i] * average) >> 8);
+    const uint32_t touchLevel = proximityLevel + ((touchThreshold[i] * average) >> 8);
+    const uint32_t releaseLevel = touchLevel - ((releaseThreshold[i] * average) >> 8);
+
+    // updateMovingAverage() in 32-bit two's complement; every branch
+    // that adapts the filter starts from the same average.
+    const uint32_t adapted = average + (uint32_t)((int32_t)(adaptationRate[i] * (sample - average)) >> 8);
+
+    // IDLE
+    const uint32_t idle = maskOf(state == IDLE);
+    const uint32_t above = maskOf(sample > proximityLevel);
+    const uint32_t delaying = delayings[i];
+    const uint32_t enter = idle & above & delaying & maskOf(now - delayStart > delayMs[i]);
+    const uint32_t idleReseed = idle & ~above & maskOf(sample < reseedLevel);
+    const uint32_t idleAdapt = idle & ~above & ~idleReseed;
+
+    const uint32_t state1 = select(enter, PROXIMITY, state);
+    const uint32_t start = idle & above & ~delaying;
+    const uint32_t delayStart1 = select(start, now, delayStart);
+    const uint32_t delaying1 = select(idle, select(start, ~0U, select(enter | ~above, 0, delaying)), delaying);
+    const uint32_t proximityStart1 = select(enter, now, proximityStarts[i]);
+    const uint32_t average1 = select(idleReseed, sample, select(idleAdapt, adapted, average));
+
+    // PROXIMITY
+    const uint32_t proximity = maskOf(state1 == PROXIMITY);
+    const uint32_t touch = proximity & maskOf(sample >= touchLevel);
+    const uint32_t drop = proximity & ~touch & maskOf(sample < proximityLevel);
+    const uint32_t proximityTimeout = proximity & ~touch & ~drop & maskOf(proximityTimeoutMs[i] > 0)
+                                      & maskOf(now - proximityStart1 > proximityTimeoutMs[i]);
+
+    const uint32_t state2 = select(touch, TOUCH, select(drop | proximityTimeout, IDLE, state1));
+    const uint32_t touchStart2 = select(touch, now, touchStarts[i]);
+    const uint32_t idleStart2 = select(drop | proximityTimeout, now, idleStarts[i]);
+    const uint32_t average2 = select(drop, adapted, select(proximityTimeout, sample, average1));
+
+    // TOUCH
+    const uint32_t touching = maskOf(state2 == TOUCH);
+    const uint32_t release = touching & maskOf(sample < releaseLevel);
+    const uint32_t hold = release & maskOf(sample >= proximityLevel);
+    const uint32_t leave = release & ~hold;
+    const uint32_t touchTimeout = touching & ~release & maskOf(touchTimeoutMs[i] > 0)
+                                  & maskOf(now - touchStart2 > touchTimeoutMs[i]);
+
+    const uint32_t state3 = select(hold, PROXIMITY, select(leave | touchTimeout, IDLE, state2));
+    const uint32_t proximityStart3 = select(hold, now, proximityStart1);
+    const uint32_t idleStart3 = select(leave | touchTimeout, now, idleStart2);
+    const uint32_t average3 = select(leave, adapted, select(touchTimeout, sample, average2));
+
+    // A pending reseed takes the sample as the average and leaves
+    // everything else untouched.
+    const uint32_t reseed = reseeds[i];
+    averages[i] = select(reseed, sample, average3);
+    states[i] = select(reseed, state, state3);
+    delayStarts[i] = select(reseed, delayStart, delayStart1);
+    delayings[i] = select(reseed, delaying, delaying1);
+    idleStarts[i] = select(reseed, idleStarts[i], idleStart3);
+    proximityStarts[i] = select(reseed, proximityStarts[i], proximityStart3);
+    touchStarts[i] = select(reseed, touchStarts[i], touchStart2);
+    reseeds[i] = 0;
+
+    proximityEvents[i] += ~reseed & idle & maskOf(state3 != IDLE) & 1;
+    touchEvents[i] += ~reseed & maskOf(state != TOUCH) & maskOf(state3 == TOUCH) & 1;
+    timeouts[i] += ~reseed & (proximityTimeout | touchTimeout) & 1;
+  }
+}
+
+void SensorFleet::run(const uint32_t* pSamples, const uint32_t* pTimesMs, size_t steps, size_t stride,
+                      size_t begin, size_t end) {
+  // Keep one tile of state in cache while it runs through all the steps.
+  for (size_t tile = begin; tile < end; tile += TILE) {
+    size_t tileEnd = tile + TILE < end ? tile + TILE : end;
+    for (size_t step = 0; step < steps; step++) {
+      update(pSamples + step * stride, pTimesMs + step * stride, tile, tileEnd);
+    }
+  }
+}
+
+void SensorFleet::run(const uint32_t* pSamples, const uint32_t* pTimesMs, size_t steps, size_t stride,
+                      unsigned threads) {
+  forEachShard(m_count, threads, [&](size_t begin, size_t end) {
+    run(pSamples, pTimesMs, steps, stride, begin, end);
+  });
+}
+
+void SensorFleet::forEachShard(size_t count, unsigned threads,
+                               const std::function<void(size_t, size_t)>& function) {
+  size_t tiles = (count + TILE - 1) / TILE;
+  if (threads < 1) threads = 1;
+  if (threads > tiles) threads = tiles ? tiles : 1;
+  if (threads == 1) {
+    function(0, count);
+    return;
+  }
+  std::vector<std::thread> workers;
+  size_t tilesPerShard = (tiles + threads - 1) / threads;
+  for (size_t first = 0; first < tiles; first += tilesPerShard) {
+    size_t begin = first * TILE;
+    size_t end = (first + tilesPerShard) * TILE;
+    if (end > count) end = count;
+    workers.push_back(std::thread(function, begin, end));
+  }
+  for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+}
+
+uint32_t SensorFleet::getIdleDurationMs(size_t sensor, uint32_t nowMs) const {
+  return m_state[sensor] == ProximitySensor::IDLE ? nowMs - m_idleStartMs[sensor] : 0;
+}
+
+uint32_t SensorFleet::getProximityDurationMs(size_t sensor, uint32_t nowMs) const {
+  return m_state[sensor] != ProximitySensor::IDLE ? nowMs - m_proximityStartMs[sensor] : 0;
+}
+
+uint32_t SensorFleet::getTouchDurationMs(size_t sensor, uint32_t nowMs) const {
+  return m_state[sensor] == ProximitySensor::TOUCH ? nowMs - m_touchStartMs[sensor] : 0;
+}
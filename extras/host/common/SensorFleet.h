@@ -0,0 +1,173 @@
+/*
+ * SensorFleet.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SENSORFLEET_H_
+#define SENSORFLEET_H_
+
+#include <ProximitySensor.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+/**
+ * Host reimplementation of ProximitySensor::update(uint32_t) for many
+ * sensors at once, used to replay fleet traces against candidate logic.
+ *
+ * State, filter and configuration live in one array per field (structure
+ * of arrays) and every field is 32 bits wide, so the per-sample kernel is
+ * a branchless loop over sensors that the compiler vectorizes, on x86 for
+ * AVX2 as well as the baseline instruction set. Sensors are processed in
+ * tiles that fit in L1 and tiles are sharded across threads.
+ *
+ * The results are bit-for-bit those of the scalar class, including the
+ * fall through from IDLE to PROXIMITY to TOUCH within one sample, unsigned
+ * wraparound of timestamps and the wraparound of the fixed-point
+ * arithmetic; `fleet --verify` checks this against HostSensor.
+ *
+ * Samples and timestamps are passed as rows with one entry per sensor.
+ * Timestamps take the place of currentTimeMs().
+ */
+class SensorFleet {
+public:
+
+  /**
+   * Sensor settings, as set through the ProximitySensor setters.
+   */
+  struct Config {
+    uint8_t adaptationRate;
+    uint8_t reseedThreshold;
+    uint8_t proximityThreshold;
+    uint8_t touchThreshold;
+    uint8_t releaseThreshold;
+    uint32_t delayMs;
+    uint32_t proximityTimeoutMs;
+    uint32_t touchTimeoutMs;
+  };
+
+  /**
+   * Reads the settings of a scalar sensor.
+   */
+  static Config configOf(const ProximitySensor& sensor);
+
+  /**
+   * Creates count sensors in the state of a newly constructed
+   * ProximitySensor at time startMs, with the library defaults.
+   */
+  SensorFleet(size_t count, uint32_t startMs = 0);
+
+  size_t size() const { return m_count; }
+
+  void configure(size_t sensor, const Config& config);
+
+  void configureAll(const Config& config);
+
+  /**
+   * Returns a sensor to the state of a newly constructed ProximitySensor
+   * at time startMs, keeping its configuration and statistics.
+   */
+  void reset(size_t sensor, uint32_t startMs);
+
+  /**
+   * Forces a filter reseed on the next sample, as ProximitySensor::reseed().
+   */
+  void reseed(size_t sensor) { m_reseed[sensor] = ~0U; }
+
+  /**
+   * Applies one sample to each sensor in [begin, end).
+   */
+  void update(const uint32_t* pSamples, const uint32_t* pTimesMs, size_t begin, size_t end);
+
+  /**
+   * Applies steps rows of samples to the sensors in [begin, end). Row n
+   * starts at pSamples + n * stride, and likewise for the timestamps.
+   */
+  void run(const uint32_t* pSamples, const uint32_t* pTimesMs, size_t steps, size_t stride,
+           size_t begin, size_t end);
+
+  /**
+   * Applies steps rows of samples to all sensors, sharded across threads.
+   */
+  void run(const uint32_t* pSamples, const uint32_t* pTimesMs, size_t steps, size_t stride,
+           unsigned threads);
+
+  /**
+   * Calls function(begin, end) for tile-aligned shards of [0, count) on
+   * the given number of threads and waits for them.
+   */
+  static void forEachShard(size_t count, unsigned threads,
+                           const std::function<void(size_t, size_t)>& function);
+
+  ProximitySensor::State getState(size_t sensor) const {
+    return (ProximitySensor::State)m_state[sensor];
+  }
+
+  uint32_t getMovingAverage(size_t sensor) const {
+    return m_average[sensor] >> 8;
+  }
+
+  /**
+   * Returns the moving average with its 8 fractional bits, the value the
+   * thresholds are computed from.
+   */
+  uint32_t getFilterValue(size_t sensor) const {
+    return m_average[sensor];
+  }
+
+  uint32_t getIdleDurationMs(size_t sensor, uint32_t nowMs) const;
+
+  uint32_t getProximityDurationMs(size_t sensor, uint32_t nowMs) const;
+
+  uint32_t getTouchDurationMs(size_t sensor, uint32_t nowMs) const;
+
+  /**
+   * Transitions counted since construction: IDLE to PROXIMITY or TOUCH,
+   * anything to TOUCH, and PROXIMITY or TOUCH timeouts.
+   */
+  uint32_t getProximityEvents(size_t sensor) const { return m_proximityEvents[sensor]; }
+
+  uint32_t getTouchEvents(size_t sensor) const { return m_touchEvents[sensor]; }
+
+  uint32_t getTimeouts(size_t sensor) const { return m_timeouts[sensor]; }
+
+  /**
+   * Sensors processed together by run(); shards are multiples of this.
+   */
+  static const size_t TILE = 256;
+
+private:
+
+  size_t m_count;
+
+  // Configuration, widened to 32 bits
+  std::vector<uint32_t> m_adaptationRate;
+  std::vector<uint32_t> m_reseedThreshold;
+  std::vector<uint32_t> m_proximityThreshold;
+  std::vector<uint32_t> m_touchThreshold;
+  std::vector<uint32_t> m_releaseThreshold;
+  std::vector<uint32_t> m_delayMs;
+  std::vector<uint32_t> m_proximityTimeoutMs;
+  std::vector<uint32_t> m_touchTimeoutMs;
+
+  // State; m_reseed is a mask (0 or ~0)
+  std::vector<uint32_t> m_average;
+  std::vector<uint32_t> m_state;
+  std::vector<uint32_t> m_reseed;
+  std::vector<uint32_t> m_delayStartMs;
+  std::vector<uint32_t> m_delaying; // all ones while debouncing
+  std::vector<uint32_t> m_idleStartMs;
+  std::vector<uint32_t> m_proximityStartMs;
+  std::vector<uint32_t> m_touchStartMs;
+
+  // Statistics
+  std::vector<uint32_t> m_proximityEvents;
+  std::vector<uint32_t> m_touchEvents;
+  std::vector<uint32_t> m_timeouts;
+
+};
+
+#endif /* SENSORFLEET_H_ */
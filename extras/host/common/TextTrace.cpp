@@ -0,0 +1,70 @@
+/*
+ * TextTrace.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <TextTrace.h>
+#include <ProximitySensor.h>
+
+#include <stdio.h>
+
+bool readTextTrace(const char* path, std::vector<TextTraceRecord>& records) {
+  FILE* file = fopen(path, "r");
+  if (!file) return false;
+  char line[128];
+  while (fgets(line, sizeof(line), file)) {
+    TextTraceRecord record;
+    unsigned long sample, average, difference, duration;
+    char state;
+    if (sscanf(line, "%lu %lu %lu %c %lu", &sample, &average, &difference, &state, &duration) != 5) continue;
+    if (state != 'I' && state != 'P' && state != 'T') continue;
+    record.sample = sample;
+    record.average = average;
+    record.difference = difference;
+    record.state = state;
+    record.durationMs = duration;
+    records.push_back(record);
+  }
+  fclose(file);
+  return true;
+}
+
+void textTraceToRecords(const std::vector<TextTraceRecord>& text, uint16_t device, uint8_t channel,
+                        uint32_t periodMs, std::vector<TraceRecord>& records) {
+  uint64_t timeMs = 0;
+  for (size_t i = 0; i < text.size(); i++) {
+    const TextTraceRecord& line = text[i];
+    if (i > 0) {
+      const TextTraceRecord& previous = text[i - 1];
+      if (line.state == previous.state && line.durationMs >= previous.durationMs) {
+        timeMs += line.durationMs - previous.durationMs;
+      }
+      else {
+        timeMs += line.durationMs > periodMs ? line.durationMs : periodMs;
+      }
+    }
+    TraceRecord record;
+    record.timeMs = timeMs;
+    record.sample = line.sample;
+    record.average = line.average;
+    record.device = device;
+    record.channel = channel;
+    record.state = line.state == 'I' ? ProximitySensor::IDLE
+                 : line.state == 'P' ? ProximitySensor::PROXIMITY : ProximitySensor::TOUCH;
+    record.transition = i > 0 && line.state != text[i - 1].state;
+    records.push_back(record);
+  }
+}
+
+bool readTrace(const char* path, uint32_t periodMs, std::vector<TraceRecord>& records) {
+  size_t size = records.size();
+  if (TraceReader::isTraceFile(path)) {
+    TraceReader reader;
+    return reader.open(path) && reader.readAll(records) && records.size() > size;
+  }
+  std::vector<TextTraceRecord> text;
+  if (!readTextTrace(path, text)) return false;
+  textTraceToRecords(text, 0, 0, periodMs, records);
+  return records.size() > size;
+}
@@ -0,0 +1,51 @@
+/*
+ * TextTrace.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef TEXTTRACE_H_
+#define TEXTTRACE_H_
+
+#include <TraceFile.h>
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * One line of the text output produced by the SensorTrace example:
+ *
+ *   <sample> <average> <difference> <I|P|T> <state duration ms>
+ */
+struct TextTraceRecord {
+  uint32_t sample;
+  uint32_t average;
+  uint32_t difference;
+  char state;
+  uint32_t durationMs;
+};
+
+/**
+ * Reads a SensorTrace capture. Lines that do not parse (serial noise,
+ * partial lines at the start of a capture) are skipped.
+ * Returns false if the file could not be opened.
+ */
+bool readTextTrace(const char* path, std::vector<TextTraceRecord>& records);
+
+/**
+ * Converts a SensorTrace capture to trace records for one source. The
+ * text has no timestamps: they are recovered from the state duration
+ * while a state holds, and across a state change the step is taken as
+ * periodMs, or the duration of the new state if that is longer.
+ */
+void textTraceToRecords(const std::vector<TextTraceRecord>& text, uint16_t device, uint8_t channel,
+                        uint32_t periodMs, std::vector<TraceRecord>& records);
+
+/**
+ * Reads a trace file (see TraceFile.h) or, failing that, a SensorTrace
+ * capture converted as device 0 channel 0. Returns false if neither
+ * yields a record.
+ */
+bool readTrace(const char* path, uint32_t periodMs, std::vector<TraceRecord>& records);
+
+#endif /* TEXTTRACE_H_ */
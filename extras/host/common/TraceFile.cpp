@@ -0,0 +1,414 @@
+/*
+ * TraceFile.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <TraceFile.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <type_traits>
+
+#define TRACE_MAGIC "PXTR"
+#define TRACE_VERSION 1
+#define HEADER_BYTES 28
+#define INDEX_ENTRY_BYTES 44
+#define COLUMN_COUNT 5
+#define CHUNK_HEADER_BYTES (4 + 4 * COLUMN_COUNT)
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+void putU16(Bytes& out, uint16_t value) {
+  for (int i = 0; i < 2; i++) out.push_back((uint8_t)(value >> (8 * i)));
+}
+
+void putU32(Bytes& out, uint32_t value) {
+  for (int i = 0; i < 4; i++) out.push_back((uint8_t)(value >> (8 * i)));
+}
+
+void putU64(Bytes& out, uint64_t value) {
+  for (int i = 0; i < 8; i++) out.push_back((uint8_t)(value >> (8 * i)));
+}
+
+uint16_t getU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | p[1] << 8);
+}
+
+uint32_t getU32(const uint8_t* p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+uint64_t getU64(const uint8_t* p) {
+  return (uint64_t)getU32(p) | (uint64_t)getU32(p + 4) << 32;
+}
+
+void putVarint(Bytes& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t)value);
+}
+
+/**
+ * Decodes one varint, leaving p after it. Returns false on a truncated or
+ * overlong encoding.
+ */
+bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+  value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (p == end) return false;
+    uint8_t byte = *p++;
+    value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+uint64_t zigzag(int64_t value) {
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/**
+ * Delta and zigzag encodes a column, starting from zero. Differences are
+ * taken modulo the column width, so a decrease stays small.
+ */
+template<typename T>
+void putDeltas(Bytes& out, const std::vector<T>& column) {
+  typedef typename std::make_signed<T>::type Signed;
+  T previous = 0;
+  for (size_t i = 0; i < column.size(); i++) {
+    putVarint(out, zigzag((Signed)(column[i] - previous)));
+    previous = column[i];
+  }
+}
+
+template<typename T>
+bool getDeltas(const uint8_t* p, const uint8_t* end, uint32_t count, std::vector<T>& column) {
+  // Every delta takes at least one byte.
+  if (count > (size_t)(end - p)) return false;
+  column.resize(count);
+  T value = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t delta;
+    if (!getVarint(p, end, delta)) return false;
+    value += (T)unzigzag(delta);
+    column[i] = value;
+  }
+  return p == end;
+}
+
+}
+
+size_t TraceColumns::size() const {
+  if (!timeMs.empty()) return timeMs.size();
+  if (!sample.empty()) return sample.size();
+  if (!average.empty()) return average.size();
+  if (!state.empty()) return state.size();
+  return source.size();
+}
+
+TraceRecord TraceColumns::record(size_t i) const {
+  TraceRecord record;
+  record.timeMs = i < timeMs.size() ? timeMs[i] : 0;
+  record.sample = i < sample.size() ? sample[i] : 0;
+  record.average = i < average.size() ? average[i] : 0;
+  record.state = i < state.size() ? state[i] & ~TRACE_TRANSITION : 0;
+  record.transition = i < state.size() && (state[i] & TRACE_TRANSITION);
+  record.device = i < source.size() ? (uint16_t)(source[i] >> 8) : 0;
+  record.channel = i < source.size() ? (uint8_t)source[i] : 0;
+  return record;
+}
+
+TraceWriter::TraceWriter()
+: m_pFile(0)
+, m_ok(false)
+, m_records(0)
+, m_lastTimeMs(0)
+, m_chunkTransitions(0)
+{
+}
+
+TraceWriter::~TraceWriter() {
+  close();
+}
+
+bool TraceWriter::open(const char* path) {
+  close();
+  m_pFile = fopen(path, "wb");
+  if (!m_pFile) return false;
+  m_ok = true;
+  m_records = 0;
+  m_lastTimeMs = 0;
+  m_chunk = TraceColumns();
+  m_chunkTransitions = 0;
+  m_index.clear();
+  m_lastState.clear();
+  // Placeholder, rewritten by close() once the index offset is known.
+  uint8_t header[HEADER_BYTES] = { 0 };
+  m_ok = fwrite(header, sizeof(header), 1, m_pFile) == 1;
+  return m_ok;
+}
+
+bool TraceWriter::add(const TraceRecord& record) {
+  if (!m_pFile || !m_ok) return false;
+  if (m_records && record.timeMs < m_lastTimeMs) return false;
+
+  uint32_t source = (uint32_t)record.device << 8 | record.channel;
+  uint8_t state = record.state & ~TRACE_TRANSITION;
+  std::map<uint32_t, uint8_t>::iterator last = m_lastState.find(source);
+  if (last != m_lastState.end() && last->second != state) {
+    state |= TRACE_TRANSITION;
+    m_chunkTransitions++;
+  }
+  m_lastState[source] = record.state & ~TRACE_TRANSITION;
+
+  m_chunk.timeMs.push_back(record.timeMs);
+  m_chunk.sample.push_back(record.sample);
+  m_chunk.average.push_back(record.average);
+  m_chunk.state.push_back(state);
+  m_chunk.source.push_back(source);
+  m_records++;
+  m_lastTimeMs = record.timeMs;
+
+  if (m_chunk.size() == CHUNK_RECORDS) return flushChunk();
+  return true;
+}
+
+bool TraceWriter::flushChunk() {
+  uint32_t count = m_chunk.size();
+  if (count == 0) return m_ok;
+
+  Bytes columns[COLUMN_COUNT];
+  putDeltas(columns[0], m_chunk.timeMs);
+  putDeltas(columns[1], m_chunk.sample);
+  putDeltas(columns[2], m_chunk.average);
+  columns[3] = m_chunk.state;
+  putDeltas(columns[4], m_chunk.source);
+
+  Bytes chunk;
+  putU32(chunk, count);
+  for (int i = 0; i < COLUMN_COUNT; i++) putU32(chunk, columns[i].size());
+  for (int i = 0; i < COLUMN_COUNT; i++) chunk.insert(chunk.end(), columns[i].begin(), columns[i].end());
+
+  TraceChunkInfo info;
+  info.offset = ftell(m_pFile);
+  info.firstRecord = m_records - count;
+  info.firstTimeMs = m_chunk.timeMs.front();
+  info.lastTimeMs = m_chunk.timeMs.back();
+  info.recordCount = count;
+  info.transitions = m_chunkTransitions;
+  info.bytes = chunk.size();
+  m_index.push_back(info);
+
+  m_chunk = TraceColumns();
+  m_chunkTransitions = 0;
+  if (fwrite(chunk.data(), chunk.size(), 1, m_pFile) != 1) m_ok = false;
+  return m_ok;
+}
+
+bool TraceWriter::close() {
+  if (!m_pFile) return false;
+  flushChunk();
+
+  Bytes index;
+  for (size_t i = 0; i < m_index.size(); i++) {
+    const TraceChunkInfo& info = m_index[i];
+    putU64(index, info.offset);
+    putU64(index, info.firstRecord);
+    putU64(index, info.firstTimeMs);
+    putU64(index, info.lastTimeMs);
+    putU32(index, info.recordCount);
+    putU32(index, info.transitions);
+    putU32(index, info.bytes);
+  }
+  uint64_t indexOffset = ftell(m_pFile);
+  if (!index.empty() && fwrite(index.data(), index.size(), 1, m_pFile) != 1) m_ok = false;
+
+  Bytes header(TRACE_MAGIC, TRACE_MAGIC + 4);
+  putU16(header, TRACE_VERSION);
+  putU16(header, CHUNK_RECORDS);
+  putU32(header, m_index.size());
+  putU64(header, m_records);
+  putU64(header, indexOffset);
+  if (fseek(m_pFile, 0, SEEK_SET) != 0 || fwrite(header.data(), header.size(), 1, m_pFile) != 1) m_ok = false;
+
+  if (fclose(m_pFile) != 0) m_ok = false;
+  m_pFile = 0;
+  return m_ok;
+}
+
+TraceReader::TraceReader()
+: m_pData(0)
+, m_size(0)
+, m_records(0)
+{
+}
+
+TraceReader::~TraceReader() {
+  close();
+}
+
+bool TraceReader::isTraceFile(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return false;
+  char magic[4];
+  bool result = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, TRACE_MAGIC, 4) == 0;
+  fclose(file);
+  return result;
+}
+
+bool TraceReader::open(const char* path) {
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat status;
+  if (fstat(fd, &status) != 0 || (size_t)status.st_size < HEADER_BYTES) {
+    ::close(fd);
+    return false;
+  }
+  void* pData = mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (pData == MAP_FAILED) return false;
+  m_pData = (const uint8_t*)pData;
+  m_size = status.st_size;
+
+  const uint8_t* p = m_pData;
+  uint32_t chunks = getU32(p + 8);
+  m_records = getU64(p + 12);
+  uint64_t indexOffset = getU64(p + 20);
+  if (memcmp(p, TRACE_MAGIC, 4) != 0 || getU16(p + 4) != TRACE_VERSION
+      || indexOffset < HEADER_BYTES || indexOffset > m_size
+      || (m_size - indexOffset) / INDEX_ENTRY_BYTES < chunks) {
+    close();
+    return false;
+  }
+
+  // Sequential access is the common case; chunks are decoded front to back.
+  madvise(pData, m_size, MADV_SEQUENTIAL);
+
+  uint64_t records = 0;
+  m_index.resize(chunks);
+  for (uint32_t i = 0; i < chunks; i++) {
+    const uint8_t* entry = m_pData + indexOffset + (size_t)i * INDEX_ENTRY_BYTES;
+    TraceChunkInfo& info = m_index[i];
+    info.offset = getU64(entry);
+    info.firstRecord = getU64(entry + 8);
+    info.firstTimeMs = getU64(entry + 16);
+    info.lastTimeMs = getU64(entry + 24);
+    info.recordCount = getU32(entry + 32);
+    info.transitions = getU32(entry + 36);
+    info.bytes = getU32(entry + 40);
+    // Every record takes at least one byte per column, which also bounds
+    // the total record count by the file size before anything is sized
+    // from it.
+    if (info.offset < HEADER_BYTES || info.offset > indexOffset || info.bytes > indexOffset - info.offset
+        || info.recordCount > info.bytes || info.firstRecord != records) {
+      close();
+      return false;
+    }
+    records += info.recordCount;
+  }
+  if (records != m_records) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void TraceReader::close() {
+  if (m_pData) munmap((void*)m_pData, m_size);
+  m_pData = 0;
+  m_size = 0;
+  m_records = 0;
+  m_index.clear();
+}
+
+size_t TraceReader::findChunk(uint64_t timeMs) const {
+  // Timestamps do not decrease, so neither do the chunk end times.
+  size_t low = 0, high = m_index.size();
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (m_index[middle].lastTimeMs < timeMs) low = middle + 1;
+    else high = middle;
+  }
+  return low;
+}
+
+bool TraceReader::readChunk(size_t chunk, TraceColumns& columns, unsigned mask) const {
+  columns = TraceColumns();
+  if (chunk >= m_index.size()) return false;
+  const TraceChunkInfo& info = m_index[chunk];
+  if (info.bytes < CHUNK_HEADER_BYTES) return false;
+  const uint8_t* p = m_pData + info.offset;
+  uint32_t count = getU32(p);
+  if (count != info.recordCount) return false;
+
+  const uint8_t* column = p + CHUNK_HEADER_BYTES;
+  const uint8_t* end = p + info.bytes;
+  for (int i = 0; i < COLUMN_COUNT; i++) {
+    uint32_t bytes = getU32(p + 4 + 4 * i);
+    if (bytes > (size_t)(end - column)) return false;
+    const uint8_t* columnEnd = column + bytes;
+    if (mask & (1 << i)) {
+      bool ok;
+      switch (i) {
+      case 0: ok = getDeltas(column, columnEnd, count, columns.timeMs); break;
+      case 1: ok = getDeltas(column, columnEnd, count, columns.sample); break;
+      case 2: ok = getDeltas(column, columnEnd, count, columns.average); break;
+      case 3:
+        ok = bytes == count;
+        if (ok) columns.state.assign(column, columnEnd);
+        break;
+      default: ok = getDeltas(column, columnEnd, count, columns.source); break;
+      }
+      if (!ok) return false;
+    }
+    column = columnEnd;
+  }
+  return true;
+}
+
+bool TraceReader::readRange(uint64_t fromMs, uint64_t toMs, std::vector<TraceRecord>& records) const {
+  TraceColumns columns;
+  for (size_t chunk = findChunk(fromMs); chunk < m_index.size() && m_index[chunk].firstTimeMs < toMs; chunk++) {
+    if (!readChunk(chunk, columns)) return false;
+    for (size_t i = 0; i < columns.size(); i++) {
+      if (columns.timeMs[i] >= fromMs && columns.timeMs[i] < toMs) records.push_back(columns.record(i));
+    }
+  }
+  return true;
+}
+
+bool TraceReader::readTransitions(std::vector<TraceRecord>& records) const {
+  TraceColumns columns;
+  for (size_t chunk = 0; chunk < m_index.size(); chunk++) {
+    if (m_index[chunk].transitions == 0) continue;
+    if (!readChunk(chunk, columns)) return false;
+    for (size_t i = 0; i < columns.size(); i++) {
+      if (columns.state[i] & TRACE_TRANSITION) records.push_back(columns.record(i));
+    }
+  }
+  return true;
+}
+
+bool TraceReader::readAll(std::vector<TraceRecord>& records) const {
+  TraceColumns columns;
+  records.reserve(records.size() + m_records);
+  for (size_t chunk = 0; chunk < m_index.size(); chunk++) {
+    if (!readChunk(chunk, columns)) return false;
+    for (size_t i = 0; i < columns.size(); i++) records.push_back(columns.record(i));
+  }
+  return true;
+}
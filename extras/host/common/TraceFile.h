@@ -0,0 +1,191 @@
+/*
+ * TraceFile.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef TRACEFILE_H_
+#define TRACEFILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <map>
+#include <vector>
+
+/**
+ * One recorded update of one sensor. A source is identified by a device
+ * number and a channel (sensor) on that device.
+ */
+struct TraceRecord {
+  uint64_t timeMs;
+  uint32_t sample;
+  uint32_t average;
+  uint16_t device;
+  uint8_t channel;
+  uint8_t state;      // ProximitySensor::State
+  bool transition;    // state differs from the previous record of this source
+};
+
+/**
+ * Decoded columns of one chunk. Columns not requested from
+ * TraceReader::readChunk() are left empty.
+ */
+struct TraceColumns {
+  std::vector<uint64_t> timeMs;
+  std::vector<uint32_t> sample;
+  std::vector<uint32_t> average;
+  std::vector<uint8_t> state;       // state, with TRACE_TRANSITION set on transitions
+  std::vector<uint32_t> source;     // device << 8 | channel
+
+  size_t size() const;
+  TraceRecord record(size_t i) const;
+};
+
+enum {
+  TRACE_COLUMN_TIME = 1,
+  TRACE_COLUMN_SAMPLE = 2,
+  TRACE_COLUMN_AVERAGE = 4,
+  TRACE_COLUMN_STATE = 8,
+  TRACE_COLUMN_SOURCE = 16,
+  TRACE_COLUMN_ALL = 31
+};
+
+const uint8_t TRACE_TRANSITION = 0x80;
+
+/**
+ * Index entry for one chunk, as stored at the end of the file.
+ */
+struct TraceChunkInfo {
+  uint64_t offset;
+  uint64_t firstRecord;
+  uint64_t firstTimeMs;
+  uint64_t lastTimeMs;
+  uint32_t recordCount;
+  uint32_t transitions;
+  uint32_t bytes;
+};
+
+/**
+ * Columnar trace file.
+ *
+ * Records are stored in chunks of up to TraceWriter::CHUNK_RECORDS. Each
+ * chunk holds one column after another so that a reader can decode only
+ * the columns it needs. Within a chunk, timestamps, samples, averages and
+ * sources are stored as zigzag varints of the difference to the previous
+ * record, starting from zero in every chunk, and states as one byte.
+ * An index at the end of the file gives the offset, time range, first
+ * record and transition count of every chunk, so a reader can seek to a
+ * time or to the next state transition without decoding the chunks in
+ * between. All integers are little-endian.
+ *
+ *   header   "PXTR" u16 version u16 chunkRecords u32 chunks
+ *            u64 records u64 indexOffset
+ *   chunk    u32 records u32 bytes[5] time sample average state source
+ *   index    one TraceChunkInfo per chunk, field by field
+ *
+ * Timestamps must not decrease within a file.
+ */
+class TraceWriter {
+public:
+
+  static const uint16_t CHUNK_RECORDS = 4096;
+
+  TraceWriter();
+  ~TraceWriter();
+
+  bool open(const char* path);
+
+  /**
+   * Appends a record; TraceRecord::transition is computed here.
+   * Returns false if the file is not open, the timestamp goes backwards
+   * or a write fails.
+   */
+  bool add(const TraceRecord& record);
+
+  uint64_t getLastTimeMs() const { return m_lastTimeMs; }
+
+  /**
+   * Writes the last chunk and the index. A file that was not closed has
+   * no index and is rejected by TraceReader.
+   */
+  bool close();
+
+private:
+
+  bool flushChunk();
+
+  FILE* m_pFile;
+  bool m_ok;
+  uint64_t m_records;
+  uint64_t m_lastTimeMs;
+  TraceColumns m_chunk;
+  uint32_t m_chunkTransitions;
+  std::vector<TraceChunkInfo> m_index;
+  std::map<uint32_t, uint8_t> m_lastState;   // by source
+};
+
+/**
+ * Memory-maps a trace file and decodes chunks on demand.
+ */
+class TraceReader {
+public:
+
+  TraceReader();
+  ~TraceReader();
+
+  /**
+   * Maps the file and reads its index. Returns false if the file cannot
+   * be read or is not a complete trace file.
+   */
+  bool open(const char* path);
+
+  void close();
+
+  /**
+   * Returns true if the file at path starts with the trace file magic.
+   */
+  static bool isTraceFile(const char* path);
+
+  uint64_t getRecordCount() const { return m_records; }
+
+  size_t getFileBytes() const { return m_size; }
+
+  size_t getChunkCount() const { return m_index.size(); }
+
+  const TraceChunkInfo& getChunk(size_t chunk) const { return m_index[chunk]; }
+
+  /**
+   * Returns the first chunk that may hold records at or after timeMs,
+   * or getChunkCount() if there is none.
+   */
+  size_t findChunk(uint64_t timeMs) const;
+
+  /**
+   * Decodes the columns selected by the TRACE_COLUMN_* mask. Returns false
+   * if the chunk is corrupt.
+   */
+  bool readChunk(size_t chunk, TraceColumns& columns, unsigned mask = TRACE_COLUMN_ALL) const;
+
+  /**
+   * Appends the records with fromMs <= timeMs < toMs.
+   */
+  bool readRange(uint64_t fromMs, uint64_t toMs, std::vector<TraceRecord>& records) const;
+
+  /**
+   * Appends the records that are state transitions, skipping chunks that
+   * have none.
+   */
+  bool readTransitions(std::vector<TraceRecord>& records) const;
+
+  bool readAll(std::vector<TraceRecord>& records) const;
+
+private:
+
+  const uint8_t* m_pData;
+  size_t m_size;
+  uint64_t m_records;
+  std::vector<TraceChunkInfo> m_index;
+};
+
+#endif /* TRACEFILE_H_ */
@@ -0,0 +1,54 @@
+/*
+ * Waveform.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <Waveform.h>
+#include <TAdcPinInput.h>
+
+#include <math.h>
+
+Waveform::Waveform(const Config& config, uint32_t seed)
+: Electrode(&PORTB, PB4, TAdcPinInput<12>::instance().getMuxIndex())
+, m_config(config)
+, m_random(seed)
+, m_noise(0.0, 1.0)
+, m_uniform(0.0, 1.0)
+, m_lastSeconds(0)
+{
+}
+
+double Waveform::envelope(double seconds) const {
+  double value = m_config.baseline + m_config.driftPerSecond * seconds;
+  if (m_config.humAmplitude != 0) {
+    value += m_config.humAmplitude * sin(2 * M_PI * m_config.humHz * seconds);
+  }
+  for (size_t i = 0; i < m_events.size(); i++) {
+    const Event& event = m_events[i];
+    double t = seconds - event.start;
+    if (t < 0 || seconds >= event.end()) continue;
+    if (t < event.rise) value += event.amplitude * t / event.rise;
+    else if (t < event.rise + event.hold) value += event.amplitude;
+    else value += event.amplitude * (1.0 - (t - event.rise - event.hold) / event.fall);
+  }
+  return value;
+}
+
+double Waveform::coupling(double seconds) {
+  if (m_config.interferenceAmplitude == 0) return 0;
+  return m_config.interferenceAmplitude * sin(2 * M_PI * m_config.interferenceHz * seconds);
+}
+
+double Waveform::level(double seconds) {
+  double value = envelope(seconds) + m_config.noiseSigma * m_noise(m_random);
+  if (m_config.spikeRate > 0) {
+    // Poisson arrivals over the interval since the previous conversion.
+    double interval = seconds - m_lastSeconds;
+    if (interval > 0 && m_uniform(m_random) < 1.0 - exp(-m_config.spikeRate * interval)) {
+      value += m_uniform(m_random) < 0.5 ? -m_config.spikeAmplitude : m_config.spikeAmplitude;
+    }
+  }
+  m_lastSeconds = seconds;
+  return value;
+}
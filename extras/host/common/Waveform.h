@@ -0,0 +1,80 @@
+/*
+ * Waveform.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef WAVEFORM_H_
+#define WAVEFORM_H_
+
+#include <Electrode.h>
+
+#include <random>
+#include <vector>
+
+/**
+ * Synthetic capacitance waveform: a baseline with drift, gaussian noise,
+ * mains hum and impulsive spikes, optional periodic interference coupled
+ * onto the sensor pin, plus a list of finger events that raise
+ * the level with a rise/hold/fall envelope.
+ *
+ * Levels are in ADC counts of charged-discharged difference. Noise and
+ * spikes are drawn independently for every conversion.
+ */
+class Waveform : public Electrode {
+public:
+
+  enum Kind { APPROACH, TOUCH, HOVER };
+
+  struct Event {
+    Kind kind;
+    double start;     // seconds
+    double rise;      // seconds from start to full amplitude
+    double hold;      // seconds at full amplitude
+    double fall;      // seconds back to baseline
+    double amplitude; // counts above baseline
+
+    double end() const { return start + rise + hold + fall; }
+  };
+
+  struct Config {
+    double baseline;       // counts
+    double driftPerSecond; // counts/s
+    double noiseSigma;     // counts
+    double humAmplitude;   // counts
+    double humHz;
+    double spikeRate;      // spikes per second
+    double spikeAmplitude; // counts, sign is random
+    double interferenceAmplitude; // counts coupled onto the sensor pin
+    double interferenceHz;        // e.g. LED PWM
+  };
+
+  Waveform(const Config& config, uint32_t seed);
+
+  void addEvent(const Event& event) { m_events.push_back(event); }
+
+  const std::vector<Event>& events() const { return m_events; }
+
+  const Config& config() const { return m_config; }
+
+  /**
+   * Noise-free level including drift, hum and events.
+   */
+  double envelope(double seconds) const;
+
+  double level(double seconds);
+
+  double coupling(double seconds);
+
+private:
+
+  Config m_config;
+  std::vector<Event> m_events;
+  std::mt19937 m_random;
+  std::normal_distribution<double> m_noise;
+  std::uniform_real_distribution<double> m_uniform;
+  double m_lastSeconds;
+
+};
+
+#endif /* WAVEFORM_H_ */
@@ -0,0 +1,598 @@
+/*
+ * Console.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Host side of the SensorConsole protocol (see SensorConsole.h).
+ *
+ *   console (--port DEVICE [--baud N] | --loopback) [COMMAND [; COMMAND]...]
+ *
+ * Runs the commands given on the command line, or reads them from standard
+ * input one per line:
+ *
+ *   info                               protocol version, sensors, features
+ *   get SENSOR [PARAMETER]             one parameter, or every parameter
+ *   set SENSOR PARAMETER VALUE         SENSOR may be "all"
+ *   reseed SENSOR
+ *   calibrate SENSOR                   discharge delay calibration
+ *   watch SENSORS [DECIMATION [COUNT]] prints COUNT (default 50) telemetry
+ *                                      records as "<time ms> <sensor>
+ *                                      <sample> <average> <I|P|T>" for
+ *                                      SENSORS ("all" or e.g. 0,2), one per
+ *                                      DECIMATION updates (default 1), and
+ *                                      fails if the records stop early
+ *   help
+ *
+ * Parameters are named as the simulator options (see help).
+ *
+ * --loopback serves the commands from a simulated device in this process:
+ * a sensor on a host electrode that is touched for one second in every
+ * four, behind a SensorConsole on a LoopbackStream. Simulated time only
+ * advances while the console waits for the device.
+ */
+
+#include <Arduino.h>
+#include <HostAvr.h>
+#include <HostSensor.h>
+#include <Electrode.h>
+#include <LoopbackStream.h>
+#include <SensorConsole.h>
+#include <TAdcPinInput.h>
+
+#include <random>
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+const int REPLY_TIMEOUT_MS = 2000;
+
+// Upper bound on the time a device takes per update, at the highest
+// resolution (1024 pairs, about 285 ms) with a little left for the loop.
+// watch waits this long for every DECIMATION updates on top of the reply
+// timeout.
+const int MAX_UPDATE_MS = 300;
+
+struct ParameterName {
+  const char* name;
+  uint8_t parameter;
+};
+
+const ParameterName PARAMETERS[] = {
+  { "resolution", SensorConsole::RESOLUTION },
+  { "adaptation", SensorConsole::FILTER_ADAPTATION_RATE },
+  { "reseed", SensorConsole::FILTER_RESEED_THRESHOLD },
+  { "proximity", SensorConsole::PROXIMITY_THRESHOLD },
+  { "touch", SensorConsole::TOUCH_THRESHOLD },
+  { "release", SensorConsole::RELEASE_THRESHOLD },
+  { "delay", SensorConsole::DELAY_MS },
+  { "proximity-timeout", SensorConsole::PROXIMITY_TIMEOUT_MS },
+  { "touch-timeout", SensorConsole::TOUCH_TIMEOUT_MS },
+  { "discharge-delay", SensorConsole::DISCHARGE_DELAY_US },
+  { "verify-interval", SensorConsole::DISCHARGE_DELAY_VERIFY_INTERVAL },
+  { "discharged-interval", SensorConsole::DISCHARGED_REFERENCE_INTERVAL },
+  { "adaptive-jitter", SensorConsole::ADAPTIVE_JITTER },
+  { "health-interval", SensorConsole::HEALTH_CHECK_INTERVAL },
+  { "open-threshold", SensorConsole::OPEN_THRESHOLD },
+  { "state", SensorConsole::STATE },
+  { "average", SensorConsole::MOVING_AVERAGE },
+  { "discharged-deviation", SensorConsole::DISCHARGED_REFERENCE_DEVIATION },
+  { "quietest-jitter-delay", SensorConsole::QUIETEST_JITTER_DELAY_US },
+  { "missed-ticks", SensorConsole::MISSED_TICKS },
+  { "health", SensorConsole::HEALTH }
+};
+
+const size_t PARAMETER_COUNT = sizeof(PARAMETERS) / sizeof(PARAMETERS[0]);
+
+const char* FEATURE_NAMES[] = { "sample", "state", "timeout", "debounce", "reseed", "stats" };
+
+const char* HEALTH_NAMES[] = { "healthy", "open", "short-ground", "short-rail", "saturated" };
+
+const char* errorName(uint8_t error) {
+  switch (error) {
+  case SensorConsole::BAD_CHECK: return "frame check failed";
+  case SensorConsole::BAD_LENGTH: return "bad frame length";
+  case SensorConsole::UNKNOWN_COMMAND: return "unknown command";
+  case SensorConsole::BAD_SENSOR: return "no such sensor";
+  case SensorConsole::UNKNOWN_PARAMETER: return "parameter not supported";
+  case SensorConsole::PARAMETER_READ_ONLY: return "parameter is read only";
+  default: return "unknown error";
+  }
+}
+
+/**
+ * Byte transport to the device.
+ */
+class Link {
+public:
+  virtual ~Link() {}
+  virtual void write(const uint8_t* data, size_t size) = 0;
+  /**
+   * Returns the next byte from the device, or -1 if none arrives within
+   * timeoutMs.
+   */
+  virtual int read(int timeoutMs) = 0;
+};
+
+class SerialLink : public Link {
+public:
+
+  SerialLink() : m_fd(-1), m_size(0), m_next(0) {}
+
+  ~SerialLink() {
+    if (m_fd >= 0) close(m_fd);
+  }
+
+  bool open(const char* path, int baud) {
+    speed_t speed;
+    switch (baud) {
+    case 9600: speed = B9600; break;
+    case 19200: speed = B19200; break;
+    case 38400: speed = B38400; break;
+    case 57600: speed = B57600; break;
+    case 115200: speed = B115200; break;
+    default: return false;
+    }
+    m_fd = ::open(path, O_RDWR | O_NOCTTY);
+    if (m_fd < 0) return false;
+    termios tio;
+    if (tcgetattr(m_fd, &tio) != 0) return false;
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cflag |= CLOCAL | CREAD;
+    return tcsetattr(m_fd, TCSANOW, &tio) == 0;
+  }
+
+  void write(const uint8_t* data, size_t size) {
+    while (size > 0) {
+      ssize_t written = ::write(m_fd, data, size);
+      if (written <= 0) return;
+      data += written;
+      size -= written;
+    }
+  }
+
+  int read(int timeoutMs) {
+    if (m_next == m_size) {
+      pollfd fds = { m_fd, POLLIN, 0 };
+      if (::poll(&fds, 1, timeoutMs) <= 0) return -1;
+      ssize_t size = ::read(m_fd, m_buffer, sizeof(m_buffer));
+      if (size <= 0) return -1;
+      m_size = size;
+      m_next = 0;
+    }
+    return m_buffer[m_next++];
+  }
+
+private:
+
+  int m_fd;
+  uint8_t m_buffer[256];
+  size_t m_size;
+  size_t m_next;
+
+};
+
+/**
+ * Resting level of 300 counts with a touch of 120 counts for one second
+ * in every four, plus a count of noise.
+ */
+class TouchElectrode : public Electrode {
+public:
+
+  TouchElectrode()
+  : Electrode(&PORTB, PB4, TAdcPinInput<12>::instance().getMuxIndex())
+  , m_random(1)
+  , m_noise(0, 1) {}
+
+  double level(double seconds) {
+    double phase = fmod(seconds, 4.0);
+    double touch = phase >= 1.0 && phase < 2.0 ? 120 : 0;
+    return 300 + touch + m_noise(m_random);
+  }
+
+private:
+
+  std::mt19937 m_random;
+  std::normal_distribution<double> m_noise;
+
+};
+
+class LoopbackLink : public Link {
+public:
+
+  LoopbackLink()
+  : m_deviceStream(64)
+  , m_hostStream(4096) {
+    host::reset();
+    m_electrode.attach();
+    ProximitySensor::begin();
+    m_pSensor = new HostSensor(&TAdcPinInput<11>::instance(), &TAdcPinInput<12>::instance());
+    m_deviceStream.connect(m_hostStream);
+    m_pConsole = new SensorConsole(m_deviceStream, *m_pSensor);
+  }
+
+  ~LoopbackLink() {
+    delete m_pConsole;
+    delete m_pSensor;
+  }
+
+  void write(const uint8_t* data, size_t size) {
+    m_hostStream.write(data, size);
+  }
+
+  /**
+   * Runs the device loop until it has sent a byte or timeoutMs of
+   * simulated time has passed.
+   */
+  int read(int timeoutMs) {
+    uint32_t startMs = millis();
+    while (!m_hostStream.available() && millis() - startMs < (uint32_t)timeoutMs) {
+      uint32_t sample = m_pSensor->update();
+      m_pConsole->poll(&sample);
+      host::advanceCycles(F_CPU / 1000);
+    }
+    return m_hostStream.read();
+  }
+
+private:
+
+  TouchElectrode m_electrode;
+  HostSensor* m_pSensor;
+  LoopbackStream m_deviceStream;
+  LoopbackStream m_hostStream;
+  SensorConsole* m_pConsole;
+
+};
+
+struct Frame {
+  uint8_t type;
+  uint8_t length;
+  uint8_t payload[255];
+};
+
+void sendFrame(Link& link, uint8_t type, const uint8_t* payload, uint8_t length) {
+  std::vector<uint8_t> frame;
+  frame.push_back((uint8_t)SensorConsole::SYNC);
+  frame.push_back(length);
+  frame.push_back(type);
+  uint8_t check = length ^ type;
+  for (uint8_t i = 0; i < length; i++) {
+    frame.push_back(payload[i]);
+    check ^= payload[i];
+  }
+  frame.push_back(check);
+  link.write(frame.data(), frame.size());
+}
+
+bool readFrame(Link& link, Frame& frame, int timeoutMs) {
+  for (;;) {
+    int byte = link.read(timeoutMs);
+    if (byte < 0) return false;
+    if (byte != SensorConsole::SYNC) continue;
+    int length = link.read(timeoutMs);
+    int type = link.read(timeoutMs);
+    if (length < 0 || type < 0) return false;
+    frame.length = length;
+    frame.type = type;
+    uint8_t check = length ^ type;
+    for (int i = 0; i < length; i++) {
+      byte = link.read(timeoutMs);
+      if (byte < 0) return false;
+      frame.payload[i] = byte;
+      check ^= byte;
+    }
+    byte = link.read(timeoutMs);
+    if (byte < 0) return false;
+    if (byte == check) return true;
+    fprintf(stderr, "console: dropped a corrupt frame\n");
+  }
+}
+
+uint32_t readValue(const Frame& frame) {
+  return frame.payload[2] | (frame.payload[3] << 8) | (frame.payload[4] << 16) | ((uint32_t)frame.payload[5] << 24);
+}
+
+/**
+ * Sends a command and waits for its reply, skipping telemetry. Returns
+ * the error reported by the device, -1 without a reply or 0 on success.
+ */
+int request(Link& link, uint8_t command, const uint8_t* payload, uint8_t length, Frame& reply) {
+  sendFrame(link, command, payload, length);
+  while (readFrame(link, reply, REPLY_TIMEOUT_MS)) {
+    if (reply.type == (command | SensorConsole::REPLY)) return 0;
+    if (reply.type == SensorConsole::ERROR && reply.length == 2) return reply.payload[1];
+  }
+  return -1;
+}
+
+bool check(int result) {
+  if (result < 0) fprintf(stderr, "console: no reply from the device\n");
+  else if (result > 0) fprintf(stderr, "console: %s\n", errorName(result));
+  return result == 0;
+}
+
+const ParameterName* findParameter(const std::string& name) {
+  for (size_t i = 0; i < PARAMETER_COUNT; i++) {
+    if (name == PARAMETERS[i].name) return &PARAMETERS[i];
+  }
+  fprintf(stderr, "console: unknown parameter %s (see help)\n", name.c_str());
+  return 0;
+}
+
+bool parseSensor(const std::string& text, bool allowAll, uint8_t& sensor) {
+  if (allowAll && text == "all") {
+    sensor = SensorConsole::ALL_SENSORS;
+    return true;
+  }
+  char* end;
+  unsigned long value = strtoul(text.c_str(), &end, 0);
+  if (text.empty() || *end || value >= SensorConsole::ALL_SENSORS) {
+    fprintf(stderr, "console: bad sensor %s\n", text.c_str());
+    return false;
+  }
+  sensor = value;
+  return true;
+}
+
+bool info(Link& link, uint8_t* pCount = 0) {
+  Frame reply;
+  if (!check(request(link, SensorConsole::PING, 0, 0, reply))) return false;
+  if (pCount) {
+    *pCount = reply.payload[1];
+    return true;
+  }
+  printf("protocol %u, %u sensors, features 0x%02x (", reply.payload[0], reply.payload[1], reply.payload[2]);
+  const char* separator = "";
+  for (int i = 0; i < 6; i++) {
+    if (reply.payload[2] & (1 << i)) {
+      printf("%s%s", separator, FEATURE_NAMES[i]);
+      separator = ",";
+    }
+  }
+  printf(")\n");
+  return true;
+}
+
+void printValue(const char* name, int width, uint8_t parameter, uint32_t value) {
+  printf("%-*s %u", width, name, value);
+  if (parameter == SensorConsole::HEALTH && value < sizeof(HEALTH_NAMES) / sizeof(HEALTH_NAMES[0])) {
+    printf(" (%s)", HEALTH_NAMES[value]);
+  }
+  printf("\n");
+}
+
+bool get(Link& link, uint8_t sensor, const ParameterName* pParameter) {
+  if (pParameter) {
+    uint8_t payload[] = { sensor, pParameter->parameter };
+    Frame reply;
+    if (!check(request(link, SensorConsole::GET, payload, sizeof(payload), reply))) return false;
+    printValue(pParameter->name, 0, pParameter->parameter, readValue(reply));
+    return true;
+  }
+  // Every parameter the device supports.
+  for (size_t i = 0; i < PARAMETER_COUNT; i++) {
+    uint8_t payload[] = { sensor, PARAMETERS[i].parameter };
+    Frame reply;
+    int result = request(link, SensorConsole::GET, payload, sizeof(payload), reply);
+    if (result == SensorConsole::UNKNOWN_PARAMETER) continue;
+    if (!check(result)) return false;
+    printValue(PARAMETERS[i].name, 22, PARAMETERS[i].parameter, readValue(reply));
+  }
+  return true;
+}
+
+bool set(Link& link, uint8_t sensor, const ParameterName& parameter, uint32_t value) {
+  uint8_t payload[] = {
+    sensor, parameter.parameter, (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)
+  };
+  Frame reply;
+  if (!check(request(link, SensorConsole::SET, payload, sizeof(payload), reply))) return false;
+  uint32_t applied = readValue(reply);
+  printf("%s %u", parameter.name, applied);
+  if (applied != value) printf(" (requested %u)", value);
+  printf("\n");
+  return true;
+}
+
+bool subscribe(Link& link, uint16_t mask, uint16_t decimation) {
+  uint8_t payload[] = { (uint8_t)mask, (uint8_t)(mask >> 8), (uint8_t)decimation, (uint8_t)(decimation >> 8) };
+  Frame reply;
+  return check(request(link, SensorConsole::SUBSCRIBE, payload, sizeof(payload), reply));
+}
+
+bool watch(Link& link, const std::string& sensors, uint16_t decimation, unsigned count) {
+  uint16_t mask = 0;
+  if (sensors == "all") {
+    uint8_t sensorCount;
+    if (!info(link, &sensorCount)) return false;
+    mask = sensorCount >= 16 ? 0xFFFF : (1U << sensorCount) - 1;
+  }
+  else {
+    std::stringstream list(sensors);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+      uint8_t sensor;
+      if (!parseSensor(item, false, sensor)) return false;
+      if (sensor >= 16) {
+        fprintf(stderr, "console: telemetry covers sensors 0 to 15\n");
+        return false;
+      }
+      mask |= 1U << sensor;
+    }
+  }
+  if (!decimation) decimation = 1;
+  if (!subscribe(link, mask, decimation)) return false;
+
+  // Telemetry carries the low 16 bits of the device time.
+  uint32_t timeMs = 0;
+  uint16_t lastTime = 0;
+  bool first = true;
+  Frame frame;
+  int timeoutMs = REPLY_TIMEOUT_MS + decimation * MAX_UPDATE_MS;
+  unsigned i = 0;
+  while (i < count && readFrame(link, frame, timeoutMs)) {
+    if (frame.type != SensorConsole::TELEMETRY || frame.length != 8) continue;
+    uint16_t time = frame.payload[2] | (frame.payload[3] << 8);
+    if (!first) timeMs += (uint16_t)(time - lastTime);
+    lastTime = time;
+    first = false;
+    printf("%u %u %u %u %c\n", timeMs, frame.payload[0], frame.payload[4] | (frame.payload[5] << 8),
+           frame.payload[6] | (frame.payload[7] << 8), "IPT"[frame.payload[1] % 3]);
+    i++;
+  }
+  bool unsubscribed = subscribe(link, 0, 0);
+  if (i < count) {
+    fprintf(stderr, "console: telemetry stopped after %u of %u records\n", i, count);
+    return false;
+  }
+  return unsubscribed;
+}
+
+void help() {
+  printf("commands:\n"
+         "  info\n"
+         "  get SENSOR [PARAMETER]\n"
+         "  set SENSOR|all PARAMETER VALUE\n"
+         "  reseed SENSOR|all\n"
+         "  calibrate SENSOR|all\n"
+         "  watch all|SENSOR[,SENSOR...] [DECIMATION [COUNT]]\n"
+         "parameters:\n");
+  for (size_t i = 0; i < PARAMETER_COUNT; i++) {
+    printf("  %s%s\n", PARAMETERS[i].name, PARAMETERS[i].parameter >= SensorConsole::READ_ONLY ? " (read only)" : "");
+  }
+}
+
+bool run(Link& link, const std::vector<std::string>& words) {
+  if (words.empty()) return true;
+  const std::string& command = words[0];
+  size_t arguments = words.size() - 1;
+  uint8_t sensor;
+
+  if (command == "help") {
+    help();
+    return true;
+  }
+  if (command == "info" && arguments == 0) return info(link);
+  if (command == "get" && (arguments == 1 || arguments == 2)) {
+    if (!parseSensor(words[1], false, sensor)) return false;
+    const ParameterName* pParameter = 0;
+    if (arguments == 2 && !(pParameter = findParameter(words[2]))) return false;
+    return get(link, sensor, pParameter);
+  }
+  if (command == "set" && arguments == 3) {
+    const ParameterName* pParameter = findParameter(words[2]);
+    if (!parseSensor(words[1], true, sensor) || !pParameter) return false;
+    return set(link, sensor, *pParameter, strtoul(words[3].c_str(), 0, 0));
+  }
+  if ((command == "reseed" || command == "calibrate") && arguments == 1) {
+    if (!parseSensor(words[1], true, sensor)) return false;
+    Frame reply;
+    uint8_t type = command == "reseed" ? SensorConsole::RESEED : SensorConsole::CALIBRATE;
+    if (!check(request(link, type, &sensor, 1, reply))) return false;
+    if (type == SensorConsole::CALIBRATE) printf("discharge-delay %u\n", readValue(reply));
+    return true;
+  }
+  if (command == "watch" && arguments >= 1 && arguments <= 3) {
+    uint16_t decimation = arguments >= 2 ? strtoul(words[2].c_str(), 0, 0) : 1;
+    unsigned count = arguments >= 3 ? strtoul(words[3].c_str(), 0, 0) : 50;
+    return watch(link, words[1], decimation, count);
+  }
+  fprintf(stderr, "console: bad command (see help)\n");
+  return false;
+}
+
+/**
+ * Runs the ';' separated commands in a line. Returns the number that failed.
+ */
+int runLine(Link& link, const std::string& line) {
+  int failures = 0;
+  std::stringstream commands(line);
+  std::string command;
+  while (std::getline(commands, command, ';')) {
+    std::stringstream words(command);
+    std::vector<std::string> list;
+    std::string word;
+    while (words >> word) list.push_back(word);
+    if (!run(link, list)) failures++;
+  }
+  return failures;
+}
+
+void usage() {
+  fprintf(stderr, "usage: console (--port DEVICE [--baud N] | --loopback) [COMMAND [; COMMAND]...]\n");
+}
+
+}
+
+int main(int argc, char** argv) {
+
+  const char* port = 0;
+  int baud = 9600;
+  bool loopback = false;
+  std::string line;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) port = argv[++i];
+    else if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc) baud = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--loopback") == 0) loopback = true;
+    else if (argv[i][0] == '-') {
+      usage();
+      return 2;
+    }
+    else {
+      if (!line.empty()) line += ' ';
+      line += argv[i];
+    }
+  }
+  if (!port == !loopback) {
+    usage();
+    return 2;
+  }
+
+  Link* pLink;
+  if (loopback) {
+    pLink = new LoopbackLink();
+  }
+  else {
+    SerialLink* pSerial = new SerialLink();
+    if (!pSerial->open(port, baud)) {
+      fprintf(stderr, "console: cannot open %s at %d baud\n", port, baud);
+      delete pSerial;
+      return 2;
+    }
+    pLink = pSerial;
+  }
+
+  int failures = 0;
+  if (!line.empty()) {
+    failures = runLine(*pLink, line);
+  }
+  else {
+    bool interactive = isatty(0);
+    char buffer[256];
+    for (;;) {
+      if (interactive) {
+        printf("> ");
+        fflush(stdout);
+      }
+      if (!fgets(buffer, sizeof(buffer), stdin)) break;
+      failures += runLine(*pLink, buffer);
+      fflush(stdout);
+    }
+  }
+
+  delete pLink;
+  return failures ? 1 : 0;
+}
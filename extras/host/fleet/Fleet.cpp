@@ -0,0 +1,468 @@
+/*
+ * Fleet.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Replays many sensor sample streams through SensorFleet (see SensorFleet.h).
+ *
+ *   fleet --verify [--sensors N] [--steps N] [--seed N]
+ *       Random configurations and streams are run through both SensorFleet
+ *       and one HostSensor per lane; state, average, durations and
+ *       transition counts must match exactly.
+ *
+ *   fleet [--sensors N] [--hours H] [--rate HZ] [--threads N] [--scalar]
+ *       Synthetic streams at the given sample rate, reporting throughput
+ *       and transition totals. --scalar runs HostSensor instead, for
+ *       comparison.
+ *
+ *   fleet [--period-ms MS] [--threads N] FILE...
+ *       Re-scores recorded traces with one sensor per source, on the
+ *       recorded timestamps. FILE is a trace file (see TraceFile.h) or a
+ *       SensorTrace capture, whose timestamps are recovered as described
+ *       for textTraceToRecords() with a sample period of MS.
+ */
+
+#include <HostAvr.h>
+#include <HostSensor.h>
+#include <SensorFleet.h>
+#include <TextTrace.h>
+#include <TAdcPinInput.h>
+
+#include <chrono>
+#include <random>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+// Rows generated and processed at a time.
+const size_t CHUNK_STEPS = 1024;
+
+HostSensor* newSensor() {
+  return new HostSensor(&TAdcPinInput<11>::instance(), &TAdcPinInput<12>::instance());
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Random settings over the same ranges as the simulator fuzzer, applied
+ * through the setters so that any clamping is reflected.
+ */
+void randomConfig(ProximitySensor& sensor, std::mt19937& random) {
+  std::uniform_int_distribution<int> byte(1, 128);
+  sensor.setFilterAdaptationRate(byte(random) / 2 + 1);
+  sensor.setFilterReseedThreshold(byte(random));
+  sensor.setProximityThreshold(byte(random) / 2 + 1);
+  sensor.setTouchThreshold(byte(random) / 2 + 1);
+  sensor.setReleaseThreshold(byte(random) / 2 + 1);
+  sensor.setDelayMs(std::uniform_int_distribution<int>(0, 200)(random));
+  sensor.setProximityTimeoutMs(random() % 3 == 0 ? 0 : std::uniform_int_distribution<int>(100, 3000)(random));
+  sensor.setTouchTimeoutMs(random() % 3 == 0 ? 0 : std::uniform_int_distribution<int>(100, 3000)(random));
+}
+
+/**
+ * Generates one lane of a verification stream: a noisy baseline with
+ * holds at random levels above and below it, random time steps, long
+ * gaps and occasional reseeds.
+ */
+struct VerifyLane {
+  std::mt19937 random;
+  uint32_t baseline;
+  uint32_t level;
+  uint32_t holdSteps;
+  uint32_t timeMs;
+
+  VerifyLane(uint32_t seed, uint32_t startMs)
+  : random(seed), baseline(0), level(0), holdSteps(0), timeMs(startMs) {
+    baseline = std::uniform_int_distribution<uint32_t>(20, 1000)(random) << 8;
+    level = baseline;
+  }
+
+  void next(uint32_t& sample, uint32_t& nowMs) {
+    if (holdSteps == 0) {
+      holdSteps = std::uniform_int_distribution<uint32_t>(1, 300)(random);
+      // Levels from well below to well above the baseline.
+      int percent = std::uniform_int_distribution<int>(-60, 150)(random);
+      level = (uint32_t)((int64_t)baseline * (100 + percent) / 100);
+      if (random() % 4 == 0) level = baseline;
+    }
+    holdSteps--;
+    int32_t noise = std::uniform_int_distribution<int32_t>(-1024, 1024)(random);
+    sample = (uint32_t)((int32_t)level + noise);
+    if (sample > (1023U << 8)) sample = level;
+    uint32_t step = random() % 64 == 0 ? std::uniform_int_distribution<uint32_t>(0, 5000)(random)
+                                       : std::uniform_int_distribution<uint32_t>(0, 40)(random);
+    timeMs += step;
+    nowMs = timeMs;
+  }
+};
+
+int verify(size_t sensors, size_t steps, uint32_t seed) {
+
+  host::reset();
+
+  std::mt19937 random(seed);
+
+  // Lanes start at random times, some close to millis() wraparound.
+  std::vector<uint32_t> startMs(sensors);
+  std::vector<HostSensor*> scalar(sensors);
+  std::vector<VerifyLane> lanes;
+  lanes.reserve(sensors);
+  std::vector<uint32_t> scalarProximityEvents(sensors, 0), scalarTouchEvents(sensors, 0);
+
+  SensorFleet fleet(sensors);
+  for (size_t i = 0; i < sensors; i++) {
+    startMs[i] = random() % 4 == 0 ? 0xFFFFFFFFU - (random() % 100000) : random() % 100000;
+    host::setMillis(startMs[i]);
+    scalar[i] = newSensor();
+    randomConfig(*scalar[i], random);
+    fleet.reset(i, startMs[i]);
+    fleet.configure(i, SensorFleet::configOf(*scalar[i]));
+    lanes.push_back(VerifyLane(random(), startMs[i]));
+  }
+
+  std::vector<uint32_t> samples(CHUNK_STEPS * sensors);
+  std::vector<uint32_t> times(CHUNK_STEPS * sensors);
+
+  size_t done = 0;
+  while (done < steps) {
+
+    // Short chunks so that the comparisons below, and the boundary
+    // steps, come often.
+    bool boundary = random() % 2;
+    size_t chunk = boundary ? 1 : std::uniform_int_distribution<size_t>(1, 64)(random);
+    if (chunk > steps - done) chunk = steps - done;
+
+    for (size_t step = 0; step < chunk; step++) {
+      for (size_t i = 0; i < sensors; i++) {
+        lanes[i].next(samples[step * sensors + i], times[step * sensors + i]);
+      }
+    }
+
+    // Boundary steps put samples exactly on, or one off, a threshold
+    // computed from the current average, so that every comparison is
+    // exercised at its edge.
+    if (boundary) {
+      for (size_t i = 0; i < sensors; i++) {
+        if (random() % 2) continue;
+        SensorFleet::Config config = SensorFleet::configOf(*scalar[i]);
+        uint32_t average = fleet.getFilterValue(i);
+        uint32_t proximity = average + ((config.proximityThreshold * average) >> 8);
+        uint32_t touch = proximity + ((config.touchThreshold * average) >> 8);
+        uint32_t levels[4] = {
+          average - ((config.reseedThreshold * average) >> 8),
+          proximity,
+          touch,
+          touch - ((config.releaseThreshold * average) >> 8)
+        };
+        samples[i] = levels[random() % 4] + (int)(random() % 3) - 1;
+      }
+    }
+
+    for (size_t i = 0; i < sensors; i++) {
+      // Occasional reseed requests between chunks.
+      if (random() % 16 == 0) {
+        scalar[i]->reseed();
+        fleet.reseed(i);
+      }
+      for (size_t step = 0; step < chunk; step++) {
+        ProximitySensor::State before = scalar[i]->getState();
+        host::setMillis(times[step * sensors + i]);
+        scalar[i]->update(samples[step * sensors + i]);
+        ProximitySensor::State after = scalar[i]->getState();
+        if (before == ProximitySensor::IDLE && after != ProximitySensor::IDLE) scalarProximityEvents[i]++;
+        if (before != ProximitySensor::TOUCH && after == ProximitySensor::TOUCH) scalarTouchEvents[i]++;
+      }
+    }
+
+    fleet.run(samples.data(), times.data(), chunk, sensors, std::thread::hardware_concurrency());
+    done += chunk;
+
+    for (size_t i = 0; i < sensors; i++) {
+      uint32_t now = times[(chunk - 1) * sensors + i];
+      host::setMillis(now);
+      const HostSensor& s = *scalar[i];
+      const char* field = 0;
+      if (s.getState() != fleet.getState(i)) field = "state";
+      else if (s.getMovingAverage() != fleet.getMovingAverage(i)) field = "moving average";
+      else if (s.getIdleDurationMs() != fleet.getIdleDurationMs(i, now)) field = "idle duration";
+      else if (s.getProximityDurationMs() != fleet.getProximityDurationMs(i, now)) field = "proximity duration";
+      else if (s.getTouchDurationMs() != fleet.getTouchDurationMs(i, now)) field = "touch duration";
+      else if (scalarProximityEvents[i] != fleet.getProximityEvents(i)) field = "proximity events";
+      else if (scalarTouchEvents[i] != fleet.getTouchEvents(i)) field = "touch events";
+      if (field) {
+        printf("mismatch in %s: sensor %zu after step %zu (seed %u)\n", field, i, done, seed);
+        printf("  scalar state %d average %u   fleet state %d average %u\n",
+               (int)s.getState(), s.getMovingAverage(), (int)fleet.getState(i), fleet.getMovingAverage(i));
+        return 1;
+      }
+    }
+  }
+
+  uint32_t proximityEvents = 0, touchEvents = 0;
+  for (size_t i = 0; i < sensors; i++) {
+    proximityEvents += scalarProximityEvents[i];
+    touchEvents += scalarTouchEvents[i];
+    delete scalar[i];
+  }
+  printf("%zu sensors x %zu steps match (%u proximity and %u touch transitions)\n",
+         sensors, steps, proximityEvents, touchEvents);
+  return 0;
+}
+
+/**
+ * Synthetic panel stream: a per-sensor baseline with xorshift noise and
+ * a touch of a few hundred milliseconds every 2^14 samples, at a per-sensor
+ * phase. Cheap enough that generation does not dominate the run.
+ */
+struct SyntheticFleet {
+  std::vector<uint32_t> state;
+  std::vector<uint32_t> baseline;
+  std::vector<uint32_t> phase;
+  uint32_t periodMs;
+
+  SyntheticFleet(size_t sensors, uint32_t rateHz, uint32_t seed)
+  : state(sensors), baseline(sensors), phase(sensors), periodMs(1000 / rateHz) {
+    std::mt19937 random(seed);
+    for (size_t i = 0; i < sensors; i++) {
+      state[i] = random() | 1;
+      baseline[i] = std::uniform_int_distribution<uint32_t>(200, 600)(random) << 8;
+      phase[i] = random();
+    }
+  }
+
+  void generate(uint32_t* pSamples, uint32_t* pTimes, size_t firstStep, size_t steps, size_t stride,
+                size_t begin, size_t end) {
+    const uint32_t EVENT_MASK = (1U << 14) - 1;
+    const uint32_t EVENT_STEPS = 40;
+    for (size_t step = 0; step < steps; step++) {
+      uint32_t* samples = pSamples + step * stride;
+      uint32_t* times = pTimes + step * stride;
+      uint32_t now = (uint32_t)((firstStep + step) * periodMs);
+      for (size_t i = begin; i < end; i++) {
+        uint32_t x = state[i];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        state[i] = x;
+        uint32_t position = ((uint32_t)(firstStep + step) + phase[i]) & EVENT_MASK;
+        uint32_t event = position < EVENT_STEPS ? baseline[i] >> 1 : 0;
+        samples[i] = baseline[i] + (x & 0x3FF) + event;
+        times[i] = now;
+      }
+    }
+  }
+};
+
+int throughput(size_t sensors, double hours, uint32_t rateHz, unsigned threads, bool useScalar) {
+
+  host::reset();
+
+  size_t steps = (size_t)(hours * 3600 * rateHz);
+  SyntheticFleet synthetic(sensors, rateHz, 1);
+  SensorFleet fleet(sensors, 0);
+  std::vector<HostSensor*> scalar;
+  if (useScalar) {
+    for (size_t i = 0; i < sensors; i++) scalar.push_back(newSensor());
+  }
+
+  std::vector<uint32_t> samples(CHUNK_STEPS * sensors);
+  std::vector<uint32_t> times(CHUNK_STEPS * sensors);
+  uint64_t proximityEvents = 0, touchEvents = 0;
+
+  double engineSeconds = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for (size_t done = 0; done < steps; done += CHUNK_STEPS) {
+    size_t chunk = steps - done < CHUNK_STEPS ? steps - done : CHUNK_STEPS;
+    SensorFleet::forEachShard(sensors, threads, [&](size_t begin, size_t end) {
+      synthetic.generate(samples.data(), times.data(), done, chunk, sensors, begin, end);
+    });
+    std::chrono::steady_clock::time_point engineStart = std::chrono::steady_clock::now();
+    if (useScalar) {
+      for (size_t i = 0; i < sensors; i++) {
+        HostSensor& sensor = *scalar[i];
+        for (size_t step = 0; step < chunk; step++) {
+          ProximitySensor::State before = sensor.getState();
+          host::setMillis(times[step * sensors + i]);
+          sensor.update(samples[step * sensors + i]);
+          ProximitySensor::State after = sensor.getState();
+          proximityEvents += before == ProximitySensor::IDLE && after != ProximitySensor::IDLE;
+          touchEvents += before != ProximitySensor::TOUCH && after == ProximitySensor::TOUCH;
+        }
+      }
+    }
+    else {
+      fleet.run(samples.data(), times.data(), chunk, sensors, threads);
+    }
+    engineSeconds += secondsSince(engineStart);
+  }
+
+  double totalSeconds = secondsSince(start);
+
+  if (!useScalar) {
+    for (size_t i = 0; i < sensors; i++) {
+      proximityEvents += fleet.getProximityEvents(i);
+      touchEvents += fleet.getTouchEvents(i);
+    }
+  }
+  for (size_t i = 0; i < scalar.size(); i++) delete scalar[i];
+
+  double samplesTotal = (double)steps * sensors;
+  double dayFactor = 24.0 / hours;
+  printf("%-20s %s, %u thread%s\n", "engine", useScalar ? "scalar HostSensor" : "SensorFleet",
+         useScalar ? 1 : threads, useScalar || threads == 1 ? "" : "s");
+  printf("%-20s %zu sensors x %zu samples (%.2f h at %u Hz)\n", "input", sensors, steps, hours, rateHz);
+  printf("%-20s %.2f ns/sample  %.1f Msamples/s\n", "engine", 1e9 * engineSeconds / samplesTotal,
+         samplesTotal / engineSeconds / 1e6);
+  printf("%-20s %.2f ns/sample\n", "with generation", 1e9 * totalSeconds / samplesTotal);
+  printf("%-20s %.1f s engine, %.1f s total\n", "one day", engineSeconds * dayFactor, totalSeconds * dayFactor);
+  printf("%-20s proximity %llu  touch %llu\n", "transitions",
+         (unsigned long long)proximityEvents, (unsigned long long)touchEvents);
+  return 0;
+}
+
+/**
+ * The records of one source in one file, replayed as one lane.
+ */
+struct TraceLane {
+  std::string name;
+  std::vector<uint32_t> samples;
+  std::vector<uint32_t> timesMs;
+  uint32_t recordedTouches;
+};
+
+bool loadLanes(const char* path, uint32_t periodMs, std::vector<TraceLane>& lanes) {
+  std::vector<TraceRecord> records;
+  if (!readTrace(path, periodMs, records)) return false;
+  std::map<uint32_t, size_t> laneOfSource;
+  size_t first = lanes.size();
+  for (size_t i = 0; i < records.size(); i++) {
+    const TraceRecord& record = records[i];
+    uint32_t source = (uint32_t)record.device << 8 | record.channel;
+    std::map<uint32_t, size_t>::iterator lane = laneOfSource.find(source);
+    if (lane == laneOfSource.end()) {
+      char suffix[16];
+      snprintf(suffix, sizeof(suffix), ":%u.%u", record.device, record.channel);
+      TraceLane newLane;
+      newLane.name = std::string(path) + suffix;
+      newLane.recordedTouches = 0;
+      lane = laneOfSource.insert(std::make_pair(source, lanes.size())).first;
+      lanes.push_back(newLane);
+    }
+    TraceLane& target = lanes[lane->second];
+    target.samples.push_back(record.sample << 8);
+    target.timesMs.push_back((uint32_t)record.timeMs);
+    if (record.transition && record.state == ProximitySensor::TOUCH) target.recordedTouches++;
+  }
+  // A file with a single source is named by its path alone.
+  if (lanes.size() == first + 1) lanes[first].name = path;
+  return true;
+}
+
+int rescore(const std::vector<const char*>& paths, uint32_t periodMs, unsigned threads) {
+
+  host::reset();
+
+  std::vector<TraceLane> lanes;
+  for (size_t i = 0; i < paths.size(); i++) {
+    if (!loadLanes(paths[i], periodMs, lanes)) {
+      fprintf(stderr, "fleet: no samples in %s\n", paths[i]);
+      return 1;
+    }
+  }
+  size_t steps = 0;
+  for (size_t i = 0; i < lanes.size(); i++) {
+    if (lanes[i].samples.size() > steps) steps = lanes[i].samples.size();
+  }
+
+  // Each lane runs on its recorded timestamps. Shorter lanes hold their
+  // last sample while their clock keeps running at periodMs.
+  size_t sensors = lanes.size();
+  SensorFleet fleet(sensors, 0);
+  for (size_t i = 0; i < sensors; i++) fleet.reset(i, lanes[i].timesMs[0]);
+  std::vector<uint32_t> samples(CHUNK_STEPS * sensors);
+  std::vector<uint32_t> times(CHUNK_STEPS * sensors);
+  for (size_t done = 0; done < steps; done += CHUNK_STEPS) {
+    size_t chunk = steps - done < CHUNK_STEPS ? steps - done : CHUNK_STEPS;
+    for (size_t step = 0; step < chunk; step++) {
+      for (size_t i = 0; i < sensors; i++) {
+        const TraceLane& lane = lanes[i];
+        size_t index = done + step;
+        size_t last = lane.samples.size() - 1;
+        if (index <= last) {
+          samples[step * sensors + i] = lane.samples[index];
+          times[step * sensors + i] = lane.timesMs[index];
+        }
+        else {
+          samples[step * sensors + i] = lane.samples[last];
+          times[step * sensors + i] = lane.timesMs[last] + (uint32_t)((index - last) * periodMs);
+        }
+      }
+    }
+    fleet.run(samples.data(), times.data(), chunk, sensors, threads);
+  }
+
+  for (size_t i = 0; i < sensors; i++) {
+    printf("%-30s samples %-8zu proximity %-5u touch %-5u (recorded %-5u) timeouts %-4u final %c\n",
+           lanes[i].name.c_str(), lanes[i].samples.size(), fleet.getProximityEvents(i), fleet.getTouchEvents(i),
+           lanes[i].recordedTouches, fleet.getTimeouts(i), "IPT"[fleet.getState(i)]);
+  }
+  return 0;
+}
+
+void usage() {
+  fprintf(stderr,
+    "usage: fleet --verify [--sensors N] [--steps N] [--seed N]\n"
+    "       fleet [--sensors N] [--hours H] [--rate HZ] [--threads N] [--scalar]\n"
+    "       fleet [--period-ms MS] [--threads N] FILE...\n");
+}
+
+}
+
+int main(int argc, char** argv) {
+
+  bool verifyMode = false;
+  bool useScalar = false;
+  size_t sensors = 0;
+  size_t steps = 20000;
+  uint32_t seed = 1;
+  double hours = 1;
+  uint32_t rateHz = 30;
+  uint32_t periodMs = 10;
+  unsigned threads = std::thread::hardware_concurrency();
+  std::vector<const char*> paths;
+
+  for (int i = 1; i < argc; i++) {
+    const char* option = argv[i];
+    if (strcmp(option, "--verify") == 0) { verifyMode = true; continue; }
+    if (strcmp(option, "--scalar") == 0) { useScalar = true; continue; }
+    if (option[0] != '-') { paths.push_back(option); continue; }
+    const char* value = i + 1 < argc ? argv[i + 1] : 0;
+    if (!value) { usage(); return 2; }
+    i++;
+    if (strcmp(option, "--sensors") == 0) sensors = strtoul(value, 0, 0);
+    else if (strcmp(option, "--steps") == 0) steps = strtoul(value, 0, 0);
+    else if (strcmp(option, "--seed") == 0) seed = strtoul(value, 0, 0);
+    else if (strcmp(option, "--hours") == 0) hours = atof(value);
+    else if (strcmp(option, "--rate") == 0) rateHz = atoi(value);
+    else if (strcmp(option, "--period-ms") == 0) periodMs = atoi(value);
+    else if (strcmp(option, "--threads") == 0) threads = atoi(value);
+    else { usage(); return 2; }
+  }
+
+  if (threads < 1) threads = 1;
+  if (rateHz < 1) rateHz = 1;
+
+  if (verifyMode) return verify(sensors ? sensors : 1000, steps, seed);
+  if (!paths.empty()) return rescore(paths, periodMs, threads);
+  return throughput(sensors ? sensors : 4000, hours, rateHz, threads, useScalar);
+}
@@ -0,0 +1,202 @@
+/*
+ * Gesture.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Scripted checks of GestureRecognizer.
+ *
+ *   gesture
+ *
+ * Each case drives a row of three sensors through touches and releases at
+ * given times, by passing resting and touch level samples to
+ * update(uint32_t), so that the recognizer sees the transitions through
+ * its state callbacks. poll(nowMs) is called every millisecond, or only at
+ * the end of the case, and the gestures it returns are compared with the
+ * expected type, pads and time. Prints the first difference of each
+ * failing case and exits non-zero if any fails.
+ */
+
+#include <Arduino.h>
+#include <HostAvr.h>
+#include <HostSensor.h>
+#include <GestureRecognizer.h>
+#include <TAdcPinInput.h>
+
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+
+namespace {
+
+const uint32_t REST_SAMPLE = 300;
+const uint32_t TOUCH_SAMPLE = 420;
+const uint8_t PADS = 3;
+
+const char* TYPE_NAMES[] = { "tap", "double-tap", "long-press", "swipe-forward", "swipe-backward" };
+
+/**
+ * A touch or release of a pad at a time. A touch reaches TOUCH at timeMs;
+ * the first touch level sample, one millisecond earlier, starts the
+ * debounce delay.
+ */
+struct Step {
+  uint32_t timeMs;
+  uint8_t pad;
+  bool touch;
+};
+
+struct Expected {
+  GestureRecognizer::Type type;
+  uint8_t pad;
+  uint8_t lastPad;
+  uint32_t timeMs;
+};
+
+struct Case {
+  const char* name;
+  uint16_t doubleTapGapMs;
+  bool pollEveryMs;
+  uint32_t endMs;
+  std::vector<Step> steps;
+  std::vector<Expected> gestures;
+  uint16_t overruns;
+};
+
+std::string describe(GestureRecognizer::Type type, uint8_t pad, uint8_t lastPad, uint32_t timeMs) {
+  char text[64];
+  snprintf(text, sizeof(text), "%s %u-%u at %u ms", TYPE_NAMES[type], pad, lastPad, timeMs);
+  return text;
+}
+
+/**
+ * Runs a case and returns an empty string, or a description of the
+ * first difference.
+ */
+std::string run(const Case& test) {
+  host::reset();
+  HostSensor* sensors[PADS];
+  ProximitySensor* pads[PADS];
+  for (uint8_t i = 0; i < PADS; i++) {
+    pads[i] = sensors[i] = new HostSensor(&TAdcPinInput<11>::instance(), &TAdcPinInput<12>::instance());
+    sensors[i]->setDelayMs(0);
+    // The first sample seeds the moving average.
+    sensors[i]->update(REST_SAMPLE << 8);
+  }
+  TGestureRecognizer<PADS> recognizer(pads);
+  recognizer.setDoubleTapGapMs(test.doubleTapGapMs);
+
+  std::vector<GestureRecognizer::Gesture> gestures;
+  GestureRecognizer::Gesture gesture;
+  for (uint32_t nowMs = 1; nowMs <= test.endMs; nowMs++) {
+    host::setMillis(nowMs);
+    for (size_t i = 0; i < test.steps.size(); i++) {
+      const Step& step = test.steps[i];
+      if (step.timeMs == nowMs || (step.touch && step.timeMs == nowMs + 1)) {
+        sensors[step.pad]->update((step.touch ? TOUCH_SAMPLE : REST_SAMPLE) << 8);
+      }
+    }
+    if (test.pollEveryMs || nowMs == test.endMs) {
+      while (recognizer.poll(gesture, nowMs)) gestures.push_back(gesture);
+    }
+  }
+
+  std::string failure;
+  for (size_t i = 0; failure.empty() && i < gestures.size() && i < test.gestures.size(); i++) {
+    const Expected& expected = test.gestures[i];
+    const GestureRecognizer::Gesture& actual = gestures[i];
+    if (actual.type != expected.type || actual.pad != expected.pad || actual.lastPad != expected.lastPad
+        || actual.timeMs != expected.timeMs) {
+      failure = "gesture " + std::to_string(i) + " is " + describe(actual.type, actual.pad, actual.lastPad, actual.timeMs)
+                + ", expected " + describe(expected.type, expected.pad, expected.lastPad, expected.timeMs);
+    }
+  }
+  if (failure.empty() && gestures.size() > test.gestures.size()) {
+    const GestureRecognizer::Gesture& extra = gestures[test.gestures.size()];
+    failure = "unexpected " + describe(extra.type, extra.pad, extra.lastPad, extra.timeMs);
+  }
+  if (failure.empty() && gestures.size() < test.gestures.size()) {
+    const Expected& missing = test.gestures[gestures.size()];
+    failure = "missing " + describe(missing.type, missing.pad, missing.lastPad, missing.timeMs);
+  }
+  if (failure.empty() && recognizer.getOverruns() != test.overruns) {
+    failure = std::to_string(recognizer.getOverruns()) + " overruns, expected " + std::to_string(test.overruns);
+  }
+
+  for (uint8_t i = 0; i < PADS; i++) delete sensors[i];
+  return failure;
+}
+
+std::vector<Case> cases() {
+  const GestureRecognizer::Type TAP = GestureRecognizer::TAP;
+  const GestureRecognizer::Type DOUBLE_TAP = GestureRecognizer::DOUBLE_TAP;
+  const GestureRecognizer::Type LONG_PRESS = GestureRecognizer::LONG_PRESS;
+  const GestureRecognizer::Type SWIPE_FORWARD = GestureRecognizer::SWIPE_FORWARD;
+  const GestureRecognizer::Type SWIPE_BACKWARD = GestureRecognizer::SWIPE_BACKWARD;
+
+  // Default times: tap 250, double tap gap 250, long press 800, swipe
+  // step 300 ms, swipes across at least 3 pads.
+  std::vector<Case> list;
+  list.push_back({ "tap", 250, true, 1000,
+                   { { 100, 1, true }, { 200, 1, false } },
+                   { { TAP, 1, 1, 200 } }, 0 });
+  list.push_back({ "double tap", 250, true, 1000,
+                   { { 100, 1, true }, { 150, 1, false }, { 300, 1, true }, { 350, 1, false } },
+                   { { DOUBLE_TAP, 1, 1, 350 } }, 0 });
+  list.push_back({ "slow second tap", 250, true, 1500,
+                   { { 100, 1, true }, { 150, 1, false }, { 500, 1, true }, { 550, 1, false } },
+                   { { TAP, 1, 1, 150 }, { TAP, 1, 1, 550 } }, 0 });
+  list.push_back({ "long press", 250, true, 1500,
+                   { { 100, 1, true }, { 1100, 1, false } },
+                   { { LONG_PRESS, 1, 1, 900 } }, 0 });
+  list.push_back({ "swipe forward", 250, true, 1500,
+                   { { 100, 0, true }, { 150, 0, false }, { 250, 1, true }, { 300, 1, false },
+                     { 400, 2, true }, { 450, 2, false } },
+                   { { SWIPE_FORWARD, 0, 2, 450 } }, 0 });
+  list.push_back({ "swipe backward", 250, true, 1500,
+                   { { 100, 2, true }, { 200, 1, true }, { 220, 2, false }, { 300, 0, true },
+                     { 320, 1, false }, { 400, 0, false } },
+                   { { SWIPE_BACKWARD, 2, 0, 400 } }, 0 });
+  // The first pad is released as a tap before the second is touched.
+  list.push_back({ "swipe after a slow step", 250, true, 1500,
+                   { { 100, 0, true }, { 120, 0, false }, { 390, 1, true }, { 420, 1, false },
+                     { 600, 2, true }, { 650, 2, false } },
+                   { { SWIPE_FORWARD, 0, 2, 650 } }, 0 });
+  list.push_back({ "swipe without double taps", 0, true, 1500,
+                   { { 100, 0, true }, { 150, 0, false }, { 250, 1, true }, { 300, 1, false },
+                     { 400, 2, true }, { 450, 2, false } },
+                   { { SWIPE_FORWARD, 0, 2, 450 } }, 0 });
+  list.push_back({ "tap without double taps", 0, true, 1000,
+                   { { 100, 1, true }, { 200, 1, false }, { 300, 1, true }, { 350, 1, false } },
+                   { { TAP, 1, 1, 200 }, { TAP, 1, 1, 350 } }, 0 });
+  list.push_back({ "too short to swipe", 250, true, 1500,
+                   { { 100, 0, true }, { 150, 0, false }, { 250, 1, true }, { 300, 1, false } },
+                   {}, 0 });
+  // Double taps are reported on release, so they fill the queue without
+  // poll(); the fifth is dropped.
+  list.push_back({ "queue overrun", 250, false, 1100,
+                   { { 100, 0, true }, { 120, 0, false }, { 140, 0, true }, { 160, 0, false },
+                     { 300, 0, true }, { 320, 0, false }, { 340, 0, true }, { 360, 0, false },
+                     { 500, 0, true }, { 520, 0, false }, { 540, 0, true }, { 560, 0, false },
+                     { 700, 0, true }, { 720, 0, false }, { 740, 0, true }, { 760, 0, false },
+                     { 900, 0, true }, { 920, 0, false }, { 940, 0, true }, { 960, 0, false } },
+                   { { DOUBLE_TAP, 0, 0, 160 }, { DOUBLE_TAP, 0, 0, 360 }, { DOUBLE_TAP, 0, 0, 560 },
+                     { DOUBLE_TAP, 0, 0, 760 } }, 1 });
+  return list;
+}
+
+}
+
+int main() {
+  std::vector<Case> list = cases();
+  int failures = 0;
+  for (size_t i = 0; i < list.size(); i++) {
+    std::string failure = run(list[i]);
+    if (!failure.empty()) {
+      printf("%s: %s\n", list[i].name, failure.c_str());
+      failures++;
+    }
+  }
+  printf("%zu of %zu cases passed\n", list.size() - failures, list.size());
+  return failures ? 1 : 0;
+}
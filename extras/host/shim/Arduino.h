@@ -0,0 +1,20 @@
+/*
+ * Arduino.h (host shim)
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HOST_ARDUINO_H_
+#define HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <Stream.h>
+
+uint32_t millis();
+uint32_t micros();
+void delayMicroseconds(unsigned int us);
+
+#endif /* HOST_ARDUINO_H_ */
@@ -0,0 +1,158 @@
+/*
+ * HostAvr.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <HostAvr.h>
+#include <Arduino.h>
+#include <avr/eeprom.h>
+
+#include <string.h>
+
+volatile uint8_t PORTB, PINB, DDRB;
+volatile uint8_t PORTC, PINC, DDRC;
+volatile uint8_t PORTD, PIND, DDRD;
+volatile uint8_t PORTE, PINE, DDRE;
+volatile uint8_t PORTF, PINF, DDRF;
+
+// ADIF is held set so that conversion polling loops complete immediately.
+volatile uint8_t ADMUX, ADCSRA = _BV(ADIF), ADCSRB, DIDR0, DIDR2;
+
+volatile uint8_t SREG;
+
+volatile uint8_t TCCR3A, TCCR3B, TIMSK3, TIFR3;
+volatile uint16_t TCNT3, OCR3A;
+
+extern "C" void TIMER3_COMPA_vect(void) __attribute__((weak));
+
+namespace {
+
+uint64_t s_cycles = 0;
+uint32_t s_conversions = 0;
+
+uint64_t s_timer3Next = 0;
+
+// ATMega32U4 EEPROM, erased state.
+uint8_t s_eeprom[1024];
+bool s_eepromInitialized = false;
+
+uint8_t* eeprom() {
+  if (!s_eepromInitialized) {
+    memset(s_eeprom, 0xFF, sizeof(s_eeprom));
+    s_eepromInitialized = true;
+  }
+  return s_eeprom;
+}
+
+host::AdcSource s_adcSource = 0;
+void* s_adcSourceData = 0;
+
+uint16_t adcPrescaler() {
+  static const uint16_t divisors[8] = { 2, 2, 4, 8, 16, 32, 64, 128 };
+  return divisors[ADCSRA & 0x07];
+}
+
+/**
+ * Timer3 in CTC mode. The compare interrupt is delivered for every period
+ * that has elapsed since the timer was first seen running; start-up is
+ * therefore accurate to the granularity of the clock advances.
+ */
+void runTimer3() {
+  static const uint16_t divisors[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+  uint16_t divisor = divisors[TCCR3B & 0x07];
+  if (!divisor || !(TCCR3B & _BV(WGM32)) || !(TIMSK3 & _BV(OCIE3A)) || !TIMER3_COMPA_vect) {
+    s_timer3Next = 0;
+    return;
+  }
+  uint64_t period = ((uint64_t)OCR3A + 1) * divisor;
+  if (s_timer3Next == 0) {
+    s_timer3Next = s_cycles + period;
+    return;
+  }
+  while (s_cycles >= s_timer3Next) {
+    TIMER3_COMPA_vect();
+    s_timer3Next += period;
+  }
+}
+
+}
+
+namespace host {
+
+void setAdcSource(AdcSource source, void* data) {
+  s_adcSource = source;
+  s_adcSourceData = data;
+}
+
+uint8_t getSelectedMux() {
+  return (ADMUX & 0x1F) | (ADCSRB & _BV(MUX5) ? 0x20 : 0);
+}
+
+uint16_t readAdc() {
+  // A normal conversion takes 13 ADC clock cycles.
+  s_cycles += 13UL * adcPrescaler();
+  s_conversions++;
+  runTimer3();
+  uint16_t value = s_adcSource ? (*s_adcSource)(getSelectedMux(), s_adcSourceData) : 0;
+  return value > 1023 ? 1023 : value;
+}
+
+uint64_t getCycles() {
+  return s_cycles;
+}
+
+void setCycles(uint64_t cycles) {
+  s_cycles = cycles;
+}
+
+void advanceCycles(uint64_t cycles) {
+  s_cycles += cycles;
+  runTimer3();
+}
+
+void setMillis(uint32_t milliseconds) {
+  s_cycles = (uint64_t)milliseconds * (F_CPU / 1000UL);
+}
+
+uint32_t getConversionCount() {
+  return s_conversions;
+}
+
+void reset() {
+  PORTB = PINB = DDRB = 0;
+  PORTC = PINC = DDRC = 0;
+  PORTD = PIND = DDRD = 0;
+  PORTE = PINE = DDRE = 0;
+  PORTF = PINF = DDRF = 0;
+  ADMUX = ADCSRB = DIDR0 = DIDR2 = 0;
+  ADCSRA = _BV(ADIF);
+  SREG = 0;
+  TCCR3A = TCCR3B = TIMSK3 = TIFR3 = 0;
+  TCNT3 = OCR3A = 0;
+  s_timer3Next = 0;
+  s_cycles = 0;
+  s_conversions = 0;
+}
+
+}
+
+uint32_t millis() {
+  return (uint32_t)(s_cycles / (F_CPU / 1000UL));
+}
+
+uint32_t micros() {
+  return (uint32_t)(s_cycles / (F_CPU / 1000000UL));
+}
+
+void delayMicroseconds(unsigned int us) {
+  host::advanceCycles((uint64_t)us * (F_CPU / 1000000UL));
+}
+
+void eeprom_read_block(void* pDestination, const void* pSource, size_t size) {
+  memcpy(pDestination, eeprom() + (uintptr_t)pSource, size);
+}
+
+void eeprom_update_block(const void* pSource, void* pDestination, size_t size) {
+  memcpy(eeprom() + (uintptr_t)pDestination, pSource, size);
+}
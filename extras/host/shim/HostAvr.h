@@ -0,0 +1,70 @@
+/*
+ * HostAvr.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HOSTAVR_H_
+#define HOSTAVR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+/**
+ * Host-side stand-in for the small part of the ATMega32U4 that the
+ * library touches. Registers are plain variables, the clock is a cycle
+ * counter advanced by the delay and ADC primitives, and ADC conversions
+ * are answered by a user supplied source function.
+ *
+ * The cycle model only accounts for the fixed costs that dominate an
+ * acquisition: busy-wait delays and ADC conversion time. Instructions
+ * executed by the library itself are not modeled; use the on-target
+ * SensorBenchmark sketch for those.
+ */
+namespace host {
+
+/**
+ * ADC source signature. Receives the selected mux index (MUX5:0) and
+ * returns the 10-bit conversion result.
+ */
+typedef uint16_t (*AdcSource)(uint8_t muxIndex, void* data);
+
+void setAdcSource(AdcSource source, void* data);
+
+/**
+ * Returns the mux index currently selected by ADMUX/ADCSRB.
+ */
+uint8_t getSelectedMux();
+
+/**
+ * Performs a conversion on the selected mux input and advances the
+ * clock by the conversion time implied by the ADC prescaler.
+ */
+uint16_t readAdc();
+
+/**
+ * Cycle counter that drives millis()/micros().
+ */
+uint64_t getCycles();
+void setCycles(uint64_t cycles);
+void advanceCycles(uint64_t cycles);
+
+void setMillis(uint32_t milliseconds);
+
+/**
+ * Number of ADC conversions performed since the last reset.
+ */
+uint32_t getConversionCount();
+
+/**
+ * Restores registers, clock and counters to their power-on values.
+ */
+void reset();
+
+}
+
+#endif /* HOSTAVR_H_ */
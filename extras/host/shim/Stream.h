@@ -0,0 +1,46 @@
+/*
+ * Stream.h (host shim)
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HOST_STREAM_H_
+#define HOST_STREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The part of the Arduino Print and Stream interfaces used by the library.
+ */
+class Print {
+public:
+
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t byte) = 0;
+
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (size-- && write(*buffer++)) written++;
+    return written;
+  }
+
+  virtual int availableForWrite() { return 0; }
+
+  virtual void flush() {}
+
+};
+
+class Stream : public Print {
+public:
+
+  virtual int available() = 0;
+
+  virtual int read() = 0;
+
+  virtual int peek() = 0;
+
+};
+
+#endif /* HOST_STREAM_H_ */
@@ -0,0 +1,16 @@
+/*
+ * avr/eeprom.h (host shim)
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HOST_AVR_EEPROM_H_
+#define HOST_AVR_EEPROM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+void eeprom_read_block(void* pDestination, const void* pSource, size_t size);
+void eeprom_update_block(const void* pSource, void* pDestination, size_t size);
+
+#endif /* HOST_AVR_EEPROM_H_ */
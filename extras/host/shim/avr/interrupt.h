@@ -0,0 +1,21 @@
+/*
+ * avr/interrupt.h (host shim)
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define cli()
+#define sei()
+
+/**
+ * Interrupt handlers become plain functions. The host clock calls the
+ * ones it models (see HostAvr.cpp) as simulated time passes.
+ */
+#define ISR(vector) extern "C" void vector(void)
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
@@ -0,0 +1,85 @@
+/*
+ * avr/io.h (host shim)
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+#include <HostAvr.h>
+
+#define _BV(bit) (1 << (bit))
+
+extern volatile uint8_t PORTB, PINB, DDRB;
+extern volatile uint8_t PORTC, PINC, DDRC;
+extern volatile uint8_t PORTD, PIND, DDRD;
+extern volatile uint8_t PORTE, PINE, DDRE;
+extern volatile uint8_t PORTF, PINF, DDRF;
+
+extern volatile uint8_t ADMUX, ADCSRA, ADCSRB, DIDR0, DIDR2;
+
+#define ADC (host::readAdc())
+
+extern volatile uint8_t SREG;
+
+extern volatile uint8_t TCCR3A, TCCR3B, TIMSK3, TIFR3;
+extern volatile uint16_t TCNT3, OCR3A;
+
+// ADMUX
+#define REFS1 7
+#define REFS0 6
+#define ADLAR 5
+
+// ADCSRA
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+
+// ADCSRB
+#define ADHSM 7
+#define MUX5 5
+
+// TCCR3B
+#define WGM33 4
+#define WGM32 3
+#define CS32 2
+#define CS31 1
+#define CS30 0
+
+// TIMSK3, TIFR3
+#define OCIE3A 1
+#define OCF3A 1
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#define PF0 0
+#define PF1 1
+#define PF4 4
+#define PF5 5
+#define PF6 6
+#define PF7 7
+
+#endif /* HOST_AVR_IO_H_ */
@@ -0,0 +1,18 @@
+/*
+ * avr/pgmspace.h (host shim)
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stddef.h>
+#include <avr/io.h>
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
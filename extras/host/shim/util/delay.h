@@ -0,0 +1,15 @@
+/*
+ * util/delay.h (host shim)
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include <HostAvr.h>
+
+#define _delay_us(us) (host::advanceCycles((uint64_t)((us) * (F_CPU / 1000000UL))))
+#define _delay_ms(ms) (host::advanceCycles((uint64_t)((ms) * (F_CPU / 1000UL))))
+
+#endif /* HOST_UTIL_DELAY_H_ */
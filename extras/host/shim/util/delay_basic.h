@@ -0,0 +1,16 @@
+/*
+ * util/delay_basic.h (host shim)
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HOST_UTIL_DELAY_BASIC_H_
+#define HOST_UTIL_DELAY_BASIC_H_
+
+#include <HostAvr.h>
+
+// Three and four cycles per iteration; a count of zero runs the full range.
+#define _delay_loop_1(count) (host::advanceCycles(3ULL * ((uint8_t)(count) ? (uint8_t)(count) : 256)))
+#define _delay_loop_2(count) (host::advanceCycles(4ULL * ((uint16_t)(count) ? (uint16_t)(count) : 65536)))
+
+#endif /* HOST_UTIL_DELAY_BASIC_H_ */
@@ -0,0 +1,747 @@
+/*
+ * Sim.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Detection latency and false trigger simulator.
+ *
+ * Drives ProximitySensor::update() through synthetic capacitance waveforms
+ * (see Waveform.h) and scores the resulting state transitions against the
+ * finger events that generated them:
+ *
+ *   latency          time from the start of an event to PROXIMITY (any event)
+ *                    or TOUCH (touch events)
+ *   false positive   PROXIMITY outside of any event, or TOUCH outside of a
+ *                    touch event
+ *   false negative   an event that ended without reaching its expected state
+ *   reseed/timeout   moving average snapped to a sample while IDLE / while
+ *                    leaving PROXIMITY or TOUCH
+ *
+ * With --fuzz N the simulator instead runs N random configurations and
+ * waveforms and checks state machine invariants after every update, and
+ * that interference detection reports nothing on waveforms without hum,
+ * interference or spikes. With --faults it checks the handling of each
+ * electrode fault modeled by Electrode::setFault().
+ * Run with --help for the full option list.
+ */
+
+#include <Arduino.h>
+#include <HostAvr.h>
+#include <HostSensor.h>
+#include <Waveform.h>
+#include <Electrode.h>
+#include <ProximitySensorArray.h>
+#include <TraceFile.h>
+#include <TAdcPinInput.h>
+// Paced runs need the Timer3 handler (see SampleTimer.h).
+#define PROXIMITY_SAMPLE_TIMER_ISR
+#include <SampleTimer.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+struct SensorConfig {
+  int resolution;
+  int adaptationRate;
+  int reseedThreshold;
+  int proximityThreshold;
+  int touchThreshold;
+  int releaseThreshold;
+  uint32_t delayMs;
+  uint32_t proximityTimeoutMs;
+  uint32_t touchTimeoutMs;
+  int dischargedInterval;
+  bool adaptiveJitter;
+};
+
+struct ScenarioConfig {
+  std::string scenario;    // approach, touch, hover, drift or mixed
+  double seconds;
+  double proximityPercent; // event amplitude relative to baseline
+  double touchPercent;
+  double hoverPercent;
+  double loopUs;           // application work between updates
+  uint16_t rateHz;         // SampleTimer paced updates if non-zero
+  uint16_t stepPairs;      // updateStep() with this many pairs if non-zero
+  uint32_t stepUs;         // updateForUs() with this budget if non-zero
+};
+
+/**
+ * Reads the library defaults from a freshly constructed sensor.
+ */
+SensorConfig defaultSensorConfig() {
+  HostSensor sensor(&TAdcPinInput<11>::instance(), &TAdcPinInput<12>::instance());
+  SensorConfig config;
+  config.resolution = sensor.getResolution();
+  config.adaptationRate = sensor.getFilterAdaptationRate();
+  config.reseedThreshold = sensor.getFilterReseedThreshold();
+  config.proximityThreshold = sensor.getProximityThreshold();
+  config.touchThreshold = sensor.getTouchThreshold();
+  config.releaseThreshold = sensor.getReleaseThreshold();
+  config.delayMs = sensor.getDelayMs();
+  config.proximityTimeoutMs = sensor.getProximityTimeoutMs();
+  config.touchTimeoutMs = sensor.getTouchTimeoutMs();
+  config.dischargedInterval = sensor.getDischargedReferenceInterval();
+  config.adaptiveJitter = sensor.isAdaptiveJitter();
+  return config;
+}
+
+void applySensorConfig(ProximitySensor& sensor, const SensorConfig& config) {
+  sensor.setResolution(config.resolution);
+  sensor.setFilterAdaptationRate(config.adaptationRate);
+  sensor.setFilterReseedThreshold(config.reseedThreshold);
+  sensor.setProximityThreshold(config.proximityThreshold);
+  sensor.setTouchThreshold(config.touchThreshold);
+  sensor.setReleaseThreshold(config.releaseThreshold);
+  sensor.setDelayMs(config.delayMs);
+  sensor.setProximityTimeoutMs(config.proximityTimeoutMs);
+  sensor.setTouchTimeoutMs(config.touchTimeoutMs);
+  sensor.setDischargedReferenceInterval(config.dischargedInterval);
+  sensor.setAdaptiveJitter(config.adaptiveJitter);
+}
+
+void printSensorConfig(FILE* file, const SensorConfig& config) {
+  fprintf(file, "--resolution %d --adaptation %d --reseed %d --proximity %d --touch %d --release %d "
+                "--delay %u --proximity-timeout %u --touch-timeout %u --discharged-interval %d",
+          config.resolution, config.adaptationRate, config.reseedThreshold,
+          config.proximityThreshold, config.touchThreshold, config.releaseThreshold,
+          config.delayMs, config.proximityTimeoutMs, config.touchTimeoutMs, config.dischargedInterval);
+  if (config.adaptiveJitter) fprintf(file, " --adaptive-jitter");
+}
+
+void printWaveformConfig(FILE* file, const Waveform::Config& config) {
+  fprintf(file, "--baseline %g --drift %g --noise %g --hum %g --hum-hz %g --spikes %g --spike-amp %g "
+                "--interference %g --interference-hz %g",
+          config.baseline, config.driftPerSecond, config.noiseSigma, config.humAmplitude,
+          config.humHz, config.spikeRate, config.spikeAmplitude,
+          config.interferenceAmplitude, config.interferenceHz);
+}
+
+Waveform::Event makeEvent(Waveform::Kind kind, double start, const ScenarioConfig& scenario, double baseline) {
+  Waveform::Event event;
+  event.kind = kind;
+  event.start = start;
+  switch (kind) {
+  case Waveform::APPROACH:
+    event.rise = 0.3; event.hold = 0.5; event.fall = 0.3;
+    event.amplitude = baseline * scenario.proximityPercent / 100;
+    break;
+  case Waveform::TOUCH:
+    event.rise = 0.2; event.hold = 0.3; event.fall = 0.2;
+    event.amplitude = baseline * scenario.touchPercent / 100;
+    break;
+  case Waveform::HOVER:
+    event.rise = 0.5; event.hold = 3.0; event.fall = 0.5;
+    event.amplitude = baseline * scenario.hoverPercent / 100;
+    break;
+  }
+  return event;
+}
+
+/**
+ * Spaces events through the run with 2-5 s of idle time between them.
+ * The first second is left idle so that the filter can seed.
+ */
+void addEvents(Waveform& waveform, const ScenarioConfig& scenario, std::mt19937& random) {
+  if (scenario.scenario == "drift") return;
+  std::uniform_real_distribution<double> gap(2.0, 5.0);
+  std::uniform_int_distribution<int> kind(0, 2);
+  double time = 1.0;
+  while (true) {
+    Waveform::Kind eventKind;
+    if (scenario.scenario == "approach") eventKind = Waveform::APPROACH;
+    else if (scenario.scenario == "touch") eventKind = Waveform::TOUCH;
+    else if (scenario.scenario == "hover") eventKind = Waveform::HOVER;
+    else eventKind = (Waveform::Kind)kind(random);
+    Waveform::Event event = makeEvent(eventKind, time, scenario, waveform.config().baseline);
+    if (event.end() + 1.0 > scenario.seconds) break;
+    waveform.addEvent(event);
+    time = event.end() + gap(random);
+  }
+}
+
+struct Score {
+  uint32_t updates;
+  double simulatedSeconds;
+  uint32_t events[3];
+  std::vector<double> proximityLatencyMs;
+  std::vector<double> touchLatencyMs;
+  uint32_t proximityFalsePositives;
+  uint32_t touchFalsePositives;
+  uint32_t proximityFalseNegatives;
+  uint32_t touchFalseNegatives;
+  uint32_t reseeds;
+  uint32_t timeouts;
+  uint32_t missedTicks;
+  // Sample deviation from the moving average while idle, in counts
+  uint32_t idleSamples;
+  double idleSum;
+  double idleSumOfSquares;
+  uint16_t interferenceHz; // detectInterference() at the end of the last run
+  uint8_t quietestDelayUs;
+
+  Score()
+  : updates(0), simulatedSeconds(0)
+  , proximityFalsePositives(0), touchFalsePositives(0)
+  , proximityFalseNegatives(0), touchFalseNegatives(0)
+  , reseeds(0), timeouts(0), missedTicks(0)
+  , idleSamples(0), idleSum(0), idleSumOfSquares(0)
+  , interferenceHz(0), quietestDelayUs(0) {
+    events[0] = events[1] = events[2] = 0;
+  }
+
+  void add(const Score& other) {
+    updates += other.updates;
+    simulatedSeconds += other.simulatedSeconds;
+    for (int i = 0; i < 3; i++) events[i] += other.events[i];
+    proximityLatencyMs.insert(proximityLatencyMs.end(), other.proximityLatencyMs.begin(), other.proximityLatencyMs.end());
+    touchLatencyMs.insert(touchLatencyMs.end(), other.touchLatencyMs.begin(), other.touchLatencyMs.end());
+    proximityFalsePositives += other.proximityFalsePositives;
+    touchFalsePositives += other.touchFalsePositives;
+    proximityFalseNegatives += other.proximityFalseNegatives;
+    touchFalseNegatives += other.touchFalseNegatives;
+    reseeds += other.reseeds;
+    timeouts += other.timeouts;
+    missedTicks += other.missedTicks;
+    idleSamples += other.idleSamples;
+    idleSum += other.idleSum;
+    idleSumOfSquares += other.idleSumOfSquares;
+    interferenceHz = other.interferenceHz;
+    quietestDelayUs = other.quietestDelayUs;
+  }
+
+  double idleNoise() const {
+    if (idleSamples < 2) return 0;
+    double mean = idleSum / idleSamples;
+    double variance = idleSumOfSquares / idleSamples - mean * mean;
+    return variance > 0 ? sqrt(variance) : 0;
+  }
+};
+
+/**
+ * Invariant checks used by the fuzzer. Returns a description of the first
+ * violation, or an empty string.
+ */
+std::string checkInvariants(const HostSensor& sensor, const SensorConfig& config, uint32_t slackMs) {
+  char message[160];
+  ProximitySensor::State state = sensor.getState();
+  if (state != ProximitySensor::IDLE && state != ProximitySensor::PROXIMITY && state != ProximitySensor::TOUCH) {
+    snprintf(message, sizeof(message), "invalid state %d", (int)state);
+    return message;
+  }
+  if (state == ProximitySensor::PROXIMITY && config.proximityTimeoutMs > 0
+      && sensor.getProximityDurationMs() > config.proximityTimeoutMs + slackMs) {
+    snprintf(message, sizeof(message), "PROXIMITY held for %u ms with a %u ms timeout",
+             sensor.getProximityDurationMs(), config.proximityTimeoutMs);
+    return message;
+  }
+  if (state == ProximitySensor::TOUCH && config.touchTimeoutMs > 0
+      && sensor.getTouchDurationMs() > config.touchTimeoutMs + slackMs) {
+    snprintf(message, sizeof(message), "TOUCH held for %u ms with a %u ms timeout",
+             sensor.getTouchDurationMs(), config.touchTimeoutMs);
+    return message;
+  }
+  if (state == ProximitySensor::TOUCH && sensor.getTouchDurationMs() > sensor.getProximityDurationMs()) {
+    snprintf(message, sizeof(message), "touch duration %u ms exceeds proximity duration %u ms",
+             sensor.getTouchDurationMs(), sensor.getProximityDurationMs());
+    return message;
+  }
+  if (state != ProximitySensor::IDLE && sensor.getIdleDurationMs() != 0) {
+    return "non-zero idle duration while active";
+  }
+  if (sensor.getMovingAverage() > 1023) {
+    snprintf(message, sizeof(message), "moving average %u out of ADC range", sensor.getMovingAverage());
+    return message;
+  }
+  return std::string();
+}
+
+/**
+ * Runs one waveform through a sensor and scores it. If pFailure is given,
+ * invariants are checked after every update and the run stops at the first
+ * violation. If pTrace is given, every update is recorded as device 0,
+ * channel 0, with timestamps offset by traceOffsetMs.
+ */
+Score simulate(const SensorConfig& config, Waveform& waveform, const ScenarioConfig& scenario,
+               std::string* pFailure, TraceWriter* pTrace = 0, uint64_t traceOffsetMs = 0) {
+
+  host::reset();
+  srand(waveform.events().size() + 1);
+  waveform.attach();
+  ProximitySensor::begin();
+
+  HostSensor sensor(&TAdcPinInput<11>::instance(), &TAdcPinInput<12>::instance());
+  applySensorConfig(sensor, config);
+
+  if (scenario.rateHz) SampleTimer::begin(scenario.rateHz);
+
+  const std::vector<Waveform::Event>& events = waveform.events();
+  std::vector<bool> proximityDetected(events.size(), false);
+  std::vector<bool> touchDetected(events.size(), false);
+
+  Score score;
+  for (size_t i = 0; i < events.size(); i++) score.events[events[i].kind]++;
+
+  // Transitions that occur this long after an event ends still belong to it.
+  const double settleSeconds = 0.5 + config.delayMs / 1000.0;
+
+  ProximitySensor::State previousState = sensor.getState();
+  uint32_t previousAverage = sensor.getMovingAverage();
+  bool seeded = false;
+  const uint64_t loopCycles = (uint64_t)(scenario.loopUs * (F_CPU / 1000000.0));
+
+  uint64_t lastUpdateCycles = 0;
+
+  while (host::getCycles() < (uint64_t)(scenario.seconds * F_CPU)) {
+
+    uint32_t sample;
+    if (scenario.rateHz) {
+      if (!sensor.updatePaced(sample)) {
+        // Poll the timer the way an otherwise idle loop would.
+        host::advanceCycles(loopCycles ? loopCycles : 10 * (F_CPU / 1000000));
+        continue;
+      }
+    }
+    else if (scenario.stepPairs || scenario.stepUs) {
+      bool complete = scenario.stepPairs ? sensor.updateStep(sample, scenario.stepPairs)
+                                         : sensor.updateForUs(sample, scenario.stepUs);
+      if (!complete) {
+        host::advanceCycles(loopCycles);
+        continue;
+      }
+    }
+    else {
+      sample = sensor.update();
+    }
+    // Time since the previous completed update bounds how late a
+    // timeout can be noticed.
+    uint32_t updateMs = (uint32_t)((host::getCycles() - lastUpdateCycles) / (F_CPU / 1000)) + 1;
+    lastUpdateCycles = host::getCycles();
+    host::advanceCycles(loopCycles);
+    score.updates++;
+
+    double now = (double)host::getCycles() / F_CPU;
+    ProximitySensor::State state = sensor.getState();
+    uint32_t average = sensor.getMovingAverage();
+
+    if (pTrace) {
+      TraceRecord record = { traceOffsetMs + millis(), sample, average, 0, 0, (uint8_t)state, false };
+      pTrace->add(record);
+    }
+
+    // Find the event, if any, that this update falls within.
+    int eventIndex = -1;
+    for (size_t i = 0; i < events.size(); i++) {
+      if (now >= events[i].start && now < events[i].end() + settleSeconds) {
+        eventIndex = i;
+        break;
+      }
+    }
+
+    if (previousState == ProximitySensor::IDLE && state != ProximitySensor::IDLE) {
+      if (eventIndex < 0) score.proximityFalsePositives++;
+      else if (!proximityDetected[eventIndex]) {
+        proximityDetected[eventIndex] = true;
+        score.proximityLatencyMs.push_back((now - events[eventIndex].start) * 1000);
+      }
+    }
+    if (previousState != ProximitySensor::TOUCH && state == ProximitySensor::TOUCH) {
+      if (eventIndex < 0 || events[eventIndex].kind != Waveform::TOUCH) score.touchFalsePositives++;
+      else if (!touchDetected[eventIndex]) {
+        touchDetected[eventIndex] = true;
+        score.touchLatencyMs.push_back((now - events[eventIndex].start) * 1000);
+      }
+    }
+
+    if (eventIndex < 0 && seeded && state == ProximitySensor::IDLE) {
+      double deviation = (double)sample - (double)average;
+      score.idleSamples++;
+      score.idleSum += deviation;
+      score.idleSumOfSquares += deviation * deviation;
+    }
+
+    // The average only lands exactly on a distant sample when the filter
+    // was reseeded, either by the reseed threshold or by a timeout.
+    bool snapped = seeded && average == sample
+                   && (previousAverage > sample + 2 || sample > previousAverage + 2);
+    if (snapped) {
+      if (previousState != ProximitySensor::IDLE && state == ProximitySensor::IDLE) score.timeouts++;
+      else if (previousState == ProximitySensor::IDLE && state == ProximitySensor::IDLE) score.reseeds++;
+    }
+
+    if (pFailure) {
+      *pFailure = checkInvariants(sensor, config, 2 * updateMs + (uint32_t)(scenario.loopUs / 1000) + 1);
+      if (!pFailure->empty()) break;
+    }
+
+    previousState = state;
+    previousAverage = average;
+    seeded = true;
+  }
+
+  for (size_t i = 0; i < events.size(); i++) {
+    if (!proximityDetected[i]) score.proximityFalseNegatives++;
+    if (events[i].kind == Waveform::TOUCH && !touchDetected[i]) score.touchFalseNegatives++;
+  }
+
+  score.simulatedSeconds = (double)host::getCycles() / F_CPU;
+  score.missedTicks = sensor.getMissedTicks();
+  score.quietestDelayUs = config.adaptiveJitter ? sensor.getQuietestJitterDelayUs() : 0;
+  score.interferenceHz = sensor.detectInterference();
+  SampleTimer::end();
+  return score;
+}
+
+double percentile(std::vector<double> values, double p) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  size_t rank = (size_t)(p / 100.0 * values.size());
+  if (rank >= values.size()) rank = values.size() - 1;
+  return values[rank];
+}
+
+void printLatency(const char* name, const std::vector<double>& values) {
+  if (values.empty()) {
+    printf("%-20s n=0\n", name);
+    return;
+  }
+  printf("%-20s n=%-5zu p50 %7.1f  p90 %7.1f  p99 %7.1f  max %7.1f ms\n", name, values.size(),
+         percentile(values, 50), percentile(values, 90), percentile(values, 99),
+         *std::max_element(values.begin(), values.end()));
+}
+
+void printScore(const Score& score) {
+  printf("%-20s %u (mean period %.2f ms)\n", "updates", score.updates,
+         score.updates ? 1000.0 * score.simulatedSeconds / score.updates : 0.0);
+  printf("%-20s approach %u  touch %u  hover %u\n", "events",
+         score.events[Waveform::APPROACH], score.events[Waveform::TOUCH], score.events[Waveform::HOVER]);
+  printLatency("proximity latency", score.proximityLatencyMs);
+  printLatency("touch latency", score.touchLatencyMs);
+  printf("%-20s proximity %u  touch %u\n", "false positives", score.proximityFalsePositives, score.touchFalsePositives);
+  printf("%-20s proximity %u  touch %u\n", "false negatives", score.proximityFalseNegatives, score.touchFalseNegatives);
+  printf("%-20s %u\n", "reseeds", score.reseeds);
+  printf("%-20s %u\n", "timeouts", score.timeouts);
+  printf("%-20s %u\n", "missed ticks", score.missedTicks);
+  printf("%-20s %.2f counts\n", "idle noise", score.idleNoise());
+  printf("%-20s %u Hz\n", "interference", score.interferenceHz);
+  if (score.quietestDelayUs) printf("%-20s %u us\n", "quietest jitter", score.quietestDelayUs);
+}
+
+/**
+ * Runs random configurations and waveforms until an invariant fails.
+ * Resolution is kept low so that many runs fit in a short time.
+ */
+int fuzz(uint32_t runs, uint32_t seed) {
+  std::mt19937 random(seed);
+  for (uint32_t run = 0; run < runs; run++) {
+    uint32_t runSeed = random();
+    std::mt19937 local(runSeed);
+    std::uniform_int_distribution<int> byte(1, 128);
+
+    SensorConfig config;
+    config.resolution = std::uniform_int_distribution<int>(0, 5)(local);
+    config.adaptationRate = byte(local) / 2 + 1;
+    config.reseedThreshold = byte(local);
+    config.proximityThreshold = byte(local) / 2 + 1;
+    config.touchThreshold = byte(local) / 2 + 1;
+    config.releaseThreshold = byte(local) / 2 + 1;
+    config.delayMs = std::uniform_int_distribution<int>(0, 200)(local);
+    config.proximityTimeoutMs = local() % 3 == 0 ? 0 : std::uniform_int_distribution<int>(100, 3000)(local);
+    config.touchTimeoutMs = local() % 3 == 0 ? 0 : std::uniform_int_distribution<int>(100, 3000)(local);
+    config.dischargedInterval = local() % 2 ? std::uniform_int_distribution<int>(2, 16)(local) : 0;
+    config.adaptiveJitter = local() % 2;
+
+    Waveform::Config waveformConfig;
+    waveformConfig.baseline = std::uniform_real_distribution<double>(50, 600)(local);
+    waveformConfig.driftPerSecond = std::uniform_real_distribution<double>(-2, 2)(local);
+    waveformConfig.noiseSigma = std::uniform_real_distribution<double>(0, 10)(local);
+    waveformConfig.humAmplitude = std::uniform_real_distribution<double>(0, 20)(local);
+    waveformConfig.humHz = local() % 2 ? 50 : 60;
+    waveformConfig.spikeRate = std::uniform_real_distribution<double>(0, 2)(local);
+    waveformConfig.spikeAmplitude = std::uniform_real_distribution<double>(0, 200)(local);
+    waveformConfig.interferenceAmplitude = std::uniform_real_distribution<double>(0, 20)(local);
+    waveformConfig.interferenceHz = std::uniform_real_distribution<double>(100, 40000)(local);
+    // A quarter of the runs have no periodic or impulsive disturbance, and
+    // detectInterference() must report none.
+    bool clean = local() % 4 == 0;
+    if (clean) {
+      waveformConfig.humAmplitude = 0;
+      waveformConfig.interferenceAmplitude = 0;
+      waveformConfig.spikeRate = 0;
+    }
+
+    ScenarioConfig scenario;
+    scenario.scenario = "mixed";
+    scenario.seconds = 20;
+    scenario.proximityPercent = std::uniform_real_distribution<double>(5, 40)(local);
+    scenario.touchPercent = scenario.proximityPercent + std::uniform_real_distribution<double>(5, 60)(local);
+    scenario.hoverPercent = std::uniform_real_distribution<double>(5, 40)(local);
+    scenario.loopUs = std::uniform_real_distribution<double>(0, 5000)(local);
+    scenario.rateHz = 0;
+    scenario.stepPairs = local() % 2 ? std::uniform_int_distribution<int>(1, 16)(local) : 0;
+    scenario.stepUs = 0;
+
+    // Events are drawn from their own generator, as in a normal run, so
+    // that the reproduction command below rebuilds the same waveform.
+    Waveform waveform(waveformConfig, runSeed);
+    std::mt19937 eventRandom(runSeed);
+    addEvents(waveform, scenario, eventRandom);
+
+    std::string failure;
+    Score score = simulate(config, waveform, scenario, &failure);
+    if (failure.empty() && clean && score.interferenceHz != 0) {
+      char message[80];
+      snprintf(message, sizeof(message), "interference of %u Hz detected on clean input", score.interferenceHz);
+      failure = message;
+    }
+    if (!failure.empty()) {
+      printf("run %u: %s\n", run, failure.c_str());
+      printf("reproduce: sim --scenario mixed --seconds 20 --seed %u --loop-us %g --step-pairs %u "
+             "--proximity-amp %g --touch-amp %g --hover-amp %g --check ",
+             runSeed, scenario.loopUs, scenario.stepPairs, scenario.proximityPercent, scenario.touchPercent, scenario.hoverPercent);
+      printSensorConfig(stdout, config);
+      printf(" ");
+      printWaveformConfig(stdout, waveformConfig);
+      printf("\n");
+      return 1;
+    }
+  }
+  printf("%u runs passed\n", runs);
+  return 0;
+}
+
+/**
+ * Electrode at a fixed level, for the fault checks.
+ */
+class FixedElectrode : public Electrode {
+public:
+  FixedElectrode(uint8_t sensorMux, double counts)
+  : Electrode(&PORTB, PB4, sensorMux), m_counts(counts) {}
+  void setLevel(double counts) { m_counts = counts; }
+  double level(double) { return m_counts; }
+private:
+  double m_counts;
+};
+
+/**
+ * Runs a two sensor ProximitySensorArray, with health checks on every
+ * update, and applies each modeled fault to the second electrode while
+ * its sensor is in TOUCH. Checks that the scheduled diagnose() classifies
+ * the fault and releases the sensor, that the array then reports 0 for it
+ * and converts only the healthy channel, and that once the fault is
+ * removed the moving average is reseeded to the electrode's new level
+ * rather than adapted toward it. Prints each failure and returns 1 if
+ * any check fails.
+ */
+int checkFaults() {
+  const Electrode::Fault FAULTS[] = { Electrode::OPEN, Electrode::SHORT_GROUND, Electrode::SHORT_RAIL,
+                                      Electrode::SATURATED };
+  const ProximitySensor::Health HEALTHS[] = { ProximitySensor::OPEN, ProximitySensor::SHORT_GROUND,
+                                              ProximitySensor::SHORT_RAIL, ProximitySensor::SATURATED };
+  const char* NAMES[] = { "open", "short to ground", "short to rail", "saturated" };
+  const uint8_t RESOLUTION = 4;
+  // Both halves of every pair of the healthy sensor, plus the pairs each
+  // sensor's diagnose() takes.
+  const uint32_t DEGRADED_CONVERSIONS = (2 << RESOLUTION) + 2 * 2 * 4;
+
+  int failures = 0;
+  for (size_t i = 0; i < sizeof(FAULTS) / sizeof(FAULTS[0]); i++) {
+    host::reset();
+    FixedElectrode first(TAdcPinInput<12>::instance().getMuxIndex(), 300);
+    FixedElectrode second(TAdcPinInput<13>::instance().getMuxIndex(), 300);
+    first.chain(&second);
+    first.attach();
+    HostSensor firstSensor(&TAdcPinInput<11>::instance(), &TAdcPinInput<12>::instance());
+    HostSensor secondSensor(&TAdcPinInput<11>::instance(), &TAdcPinInput<13>::instance());
+    ProximitySensor* sensors[] = { &firstSensor, &secondSensor };
+    ProximitySensorArray array(sensors, 2);
+    array.setResolution(RESOLUTION);
+    for (uint8_t j = 0; j < 2; j++) {
+      sensors[j]->setDelayMs(0);
+      sensors[j]->setHealthCheckInterval(1);
+    }
+
+    std::vector<std::string> problems;
+    char text[96];
+    uint32_t samples[2];
+    array.update(samples);
+    // The first touch level update starts the debounce delay.
+    second.setLevel(420);
+    array.update(samples);
+    array.update(samples);
+    if (secondSensor.getState() != ProximitySensor::TOUCH) problems.push_back("no TOUCH before the fault");
+
+    second.setFault(FAULTS[i]);
+    uint32_t conversions = host::getConversionCount();
+    array.update(samples);
+    conversions = host::getConversionCount() - conversions;
+    if (secondSensor.getHealth() != HEALTHS[i]) {
+      snprintf(text, sizeof(text), "diagnosed as health %u, expected %u", secondSensor.getHealth(), HEALTHS[i]);
+      problems.push_back(text);
+    }
+    if (secondSensor.getState() != ProximitySensor::IDLE) problems.push_back("not released to IDLE");
+    if (samples[1] != 0) {
+      snprintf(text, sizeof(text), "faulty channel sampled at %u", samples[1]);
+      problems.push_back(text);
+    }
+    if (conversions != DEGRADED_CONVERSIONS) {
+      snprintf(text, sizeof(text), "%u conversions, expected %u", conversions, DEGRADED_CONVERSIONS);
+      problems.push_back(text);
+    }
+    if (!firstSensor.isHealthy() || samples[0] != 300) {
+      snprintf(text, sizeof(text), "healthy channel sampled at %u", samples[0]);
+      problems.push_back(text);
+    }
+
+    // The baseline moved while the electrode was faulty.
+    second.setLevel(360);
+    second.setFault(Electrode::NO_FAULT);
+    array.update(samples);
+    if (!secondSensor.isHealthy()) problems.push_back("not HEALTHY after recovery");
+    if (samples[1] != 360 || secondSensor.getMovingAverage() != 360
+        || secondSensor.getState() != ProximitySensor::IDLE) {
+      snprintf(text, sizeof(text), "sample %u, average %u and state %u after recovery, expected 360, 360 and IDLE",
+               samples[1], secondSensor.getMovingAverage(), secondSensor.getState());
+      problems.push_back(text);
+    }
+
+    for (size_t j = 0; j < problems.size(); j++) printf("%s: %s\n", NAMES[i], problems[j].c_str());
+    failures += !problems.empty();
+  }
+  printf("%zu of %zu faults handled\n", sizeof(FAULTS) / sizeof(FAULTS[0]) - failures, sizeof(FAULTS) / sizeof(FAULTS[0]));
+  return failures ? 1 : 0;
+}
+
+void usage() {
+  fprintf(stderr,
+    "usage: sim [options]\n"
+    "  scenario:  --scenario approach|touch|hover|drift|mixed  --seconds S  --runs N  --seed N\n"
+    "             --proximity-amp PCT  --touch-amp PCT  --hover-amp PCT  --loop-us US\n"
+    "             --rate HZ (SampleTimer paced updates)\n"
+    "             --step-pairs N | --step-us US (stepped updates, --loop-us between steps)\n"
+    "  waveform:  --baseline COUNTS  --drift COUNTS/S  --noise SIGMA  --hum COUNTS  --hum-hz HZ\n"
+    "             --spikes PER_S  --spike-amp COUNTS  --interference COUNTS  --interference-hz HZ\n"
+    "  sensor:    --resolution N  --adaptation N  --reseed N  --proximity N  --touch N  --release N\n"
+    "             --delay MS  --proximity-timeout MS  --touch-timeout MS\n"
+    "             --discharged-interval N (single-ended, discharged half every N pairs)\n"
+    "             --adaptive-jitter\n"
+    "  checking:  --check (invariants on every update)  --fuzz N (random runs)\n"
+    "             --faults (electrode fault handling)\n"
+    "  output:    --write-trace FILE (record every update, see TraceFile.h)\n");
+}
+
+}
+
+int main(int argc, char** argv) {
+
+  SensorConfig config = defaultSensorConfig();
+
+  Waveform::Config waveformConfig;
+  waveformConfig.baseline = 300;
+  waveformConfig.driftPerSecond = 0;
+  waveformConfig.noiseSigma = 2;
+  waveformConfig.humAmplitude = 0;
+  waveformConfig.humHz = 50;
+  waveformConfig.spikeRate = 0;
+  waveformConfig.spikeAmplitude = 100;
+  waveformConfig.interferenceAmplitude = 0;
+  waveformConfig.interferenceHz = 31250;
+
+  ScenarioConfig scenario;
+  scenario.scenario = "mixed";
+  scenario.seconds = 60;
+  scenario.proximityPercent = 20;
+  scenario.touchPercent = 50;
+  scenario.hoverPercent = 15;
+  scenario.loopUs = 0;
+  scenario.rateHz = 0;
+  scenario.stepPairs = 0;
+  scenario.stepUs = 0;
+
+  uint32_t runs = 1;
+  uint32_t seed = 1;
+  uint32_t fuzzRuns = 0;
+  bool check = false;
+  const char* tracePath = 0;
+
+  for (int i = 1; i < argc; i++) {
+    const char* option = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : 0;
+    if (strcmp(option, "--check") == 0) { check = true; continue; }
+    if (strcmp(option, "--faults") == 0) return checkFaults();
+    if (strcmp(option, "--adaptive-jitter") == 0) { config.adaptiveJitter = true; continue; }
+    if (!value) { usage(); return 2; }
+    i++;
+    if (strcmp(option, "--scenario") == 0) scenario.scenario = value;
+    else if (strcmp(option, "--seconds") == 0) scenario.seconds = atof(value);
+    else if (strcmp(option, "--runs") == 0) runs = atoi(value);
+    else if (strcmp(option, "--seed") == 0) seed = strtoul(value, 0, 0);
+    else if (strcmp(option, "--proximity-amp") == 0) scenario.proximityPercent = atof(value);
+    else if (strcmp(option, "--touch-amp") == 0) scenario.touchPercent = atof(value);
+    else if (strcmp(option, "--hover-amp") == 0) scenario.hoverPercent = atof(value);
+    else if (strcmp(option, "--loop-us") == 0) scenario.loopUs = atof(value);
+    else if (strcmp(option, "--rate") == 0) scenario.rateHz = atoi(value);
+    else if (strcmp(option, "--step-pairs") == 0) scenario.stepPairs = atoi(value);
+    else if (strcmp(option, "--step-us") == 0) scenario.stepUs = atoi(value);
+    else if (strcmp(option, "--baseline") == 0) waveformConfig.baseline = atof(value);
+    else if (strcmp(option, "--drift") == 0) waveformConfig.driftPerSecond = atof(value);
+    else if (strcmp(option, "--noise") == 0) waveformConfig.noiseSigma = atof(value);
+    else if (strcmp(option, "--hum") == 0) waveformConfig.humAmplitude = atof(value);
+    else if (strcmp(option, "--hum-hz") == 0) waveformConfig.humHz = atof(value);
+    else if (strcmp(option, "--spikes") == 0) waveformConfig.spikeRate = atof(value);
+    else if (strcmp(option, "--spike-amp") == 0) waveformConfig.spikeAmplitude = atof(value);
+    else if (strcmp(option, "--interference") == 0) waveformConfig.interferenceAmplitude = atof(value);
+    else if (strcmp(option, "--interference-hz") == 0) waveformConfig.interferenceHz = atof(value);
+    else if (strcmp(option, "--resolution") == 0) config.resolution = atoi(value);
+    else if (strcmp(option, "--adaptation") == 0) config.adaptationRate = atoi(value);
+    else if (strcmp(option, "--reseed") == 0) config.reseedThreshold = atoi(value);
+    else if (strcmp(option, "--proximity") == 0) config.proximityThreshold = atoi(value);
+    else if (strcmp(option, "--touch") == 0) config.touchThreshold = atoi(value);
+    else if (strcmp(option, "--release") == 0) config.releaseThreshold = atoi(value);
+    else if (strcmp(option, "--delay") == 0) config.delayMs = strtoul(value, 0, 0);
+    else if (strcmp(option, "--proximity-timeout") == 0) config.proximityTimeoutMs = strtoul(value, 0, 0);
+    else if (strcmp(option, "--touch-timeout") == 0) config.touchTimeoutMs = strtoul(value, 0, 0);
+    else if (strcmp(option, "--discharged-interval") == 0) config.dischargedInterval = atoi(value);
+    else if (strcmp(option, "--fuzz") == 0) fuzzRuns = atoi(value);
+    else if (strcmp(option, "--write-trace") == 0) tracePath = value;
+    else { usage(); return 2; }
+  }
+
+  if (fuzzRuns > 0) return fuzz(fuzzRuns, seed);
+
+  TraceWriter trace;
+  if (tracePath && !trace.open(tracePath)) {
+    fprintf(stderr, "sim: cannot write %s\n", tracePath);
+    return 2;
+  }
+
+  Score total;
+  for (uint32_t run = 0; run < runs; run++) {
+    std::mt19937 random(seed + run);
+    Waveform waveform(waveformConfig, seed + run);
+    addEvents(waveform, scenario, random);
+    std::string failure;
+    // Runs follow one another in the trace.
+    uint64_t traceOffsetMs = run && tracePath ? trace.getLastTimeMs() + 1 : 0;
+    total.add(simulate(config, waveform, scenario, check ? &failure : 0, tracePath ? &trace : 0, traceOffsetMs));
+    if (!failure.empty()) {
+      printf("seed %u: %s\n", seed + run, failure.c_str());
+      return 1;
+    }
+  }
+  if (tracePath && !trace.close()) {
+    fprintf(stderr, "sim: cannot write %s\n", tracePath);
+    return 2;
+  }
+  printScore(total);
+  return 0;
+}
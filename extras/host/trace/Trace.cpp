@@ -0,0 +1,169 @@
+/*
+ * Trace.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Converts and inspects trace files (see TraceFile.h).
+ *
+ *   trace convert [--period-ms MS] [--device N] OUT FILE...
+ *       Writes the SensorTrace captures (or trace files) to OUT, capture
+ *       n as channel n of the device, merged in time order. Capture
+ *       timestamps are recovered as described for textTraceToRecords().
+ *
+ *   trace info FILE
+ *       Record, chunk and transition counts, time range, size per record
+ *       and decode speed.
+ *
+ *   trace dump [--from MS] [--to MS] [--transitions] FILE
+ *       Prints records as "<time ms> <device>.<channel> <sample> <average>
+ *       <I|P|T>", seeking through the chunk index to the time range or to
+ *       the chunks holding transitions.
+ */
+
+#include <TextTrace.h>
+#include <TraceFile.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+// Bytes per record of the same fields in fixed-width binary.
+const size_t RAW_RECORD_BYTES = 8 + 4 + 4 + 2 + 1 + 1;
+
+bool earlier(const TraceRecord& a, const TraceRecord& b) {
+  return a.timeMs < b.timeMs;
+}
+
+int convert(const char* outPath, const std::vector<const char*>& paths, uint32_t periodMs, uint16_t device) {
+  std::vector<TraceRecord> records;
+  for (size_t i = 0; i < paths.size(); i++) {
+    std::vector<TraceRecord> file;
+    if (!readTrace(paths[i], periodMs, file)) {
+      fprintf(stderr, "trace: no samples in %s\n", paths[i]);
+      return 1;
+    }
+    for (size_t j = 0; j < file.size(); j++) {
+      file[j].device = device;
+      file[j].channel = i;
+    }
+    records.insert(records.end(), file.begin(), file.end());
+  }
+  // Stable, so each source keeps its order at equal timestamps.
+  std::stable_sort(records.begin(), records.end(), earlier);
+
+  TraceWriter writer;
+  bool ok = writer.open(outPath);
+  for (size_t i = 0; ok && i < records.size(); i++) ok = writer.add(records[i]);
+  if (!writer.close() || !ok) {
+    fprintf(stderr, "trace: cannot write %s\n", outPath);
+    return 1;
+  }
+  printf("%s: %zu records from %zu files\n", outPath, records.size(), paths.size());
+  return 0;
+}
+
+int info(const char* path) {
+  TraceReader reader;
+  if (!reader.open(path)) {
+    fprintf(stderr, "trace: %s is not a trace file\n", path);
+    return 1;
+  }
+  uint64_t records = reader.getRecordCount();
+  uint64_t transitions = 0;
+  for (size_t i = 0; i < reader.getChunkCount(); i++) transitions += reader.getChunk(i).transitions;
+
+  printf("%-20s %llu\n", "records", (unsigned long long)records);
+  printf("%-20s %zu\n", "chunks", reader.getChunkCount());
+  printf("%-20s %llu\n", "transitions", (unsigned long long)transitions);
+  if (records == 0) return 0;
+  printf("%-20s %llu .. %llu ms\n", "time", (unsigned long long)reader.getChunk(0).firstTimeMs,
+         (unsigned long long)reader.getChunk(reader.getChunkCount() - 1).lastTimeMs);
+  printf("%-20s %zu (%.2f per record, %.1fx smaller than fixed width)\n", "bytes", reader.getFileBytes(),
+         (double)reader.getFileBytes() / records, (double)RAW_RECORD_BYTES * records / reader.getFileBytes());
+
+  TraceColumns columns;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < reader.getChunkCount(); i++) {
+    if (!reader.readChunk(i, columns)) {
+      fprintf(stderr, "trace: chunk %zu of %s is corrupt\n", i, path);
+      return 1;
+    }
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  printf("%-20s %.1f ns/record\n", "decode", ns / records);
+  return 0;
+}
+
+int dump(const char* path, uint64_t fromMs, uint64_t toMs, bool transitions) {
+  TraceReader reader;
+  if (!reader.open(path)) {
+    fprintf(stderr, "trace: %s is not a trace file\n", path);
+    return 1;
+  }
+  std::vector<TraceRecord> records;
+  bool ok = transitions ? reader.readTransitions(records) : reader.readRange(fromMs, toMs, records);
+  if (!ok) {
+    fprintf(stderr, "trace: %s is corrupt\n", path);
+    return 1;
+  }
+  for (size_t i = 0; i < records.size(); i++) {
+    const TraceRecord& record = records[i];
+    if (record.timeMs < fromMs || record.timeMs >= toMs) continue;
+    printf("%llu %u.%u %u %u %c\n", (unsigned long long)record.timeMs, record.device, record.channel,
+           record.sample, record.average, "IPT"[record.state % 3]);
+  }
+  return 0;
+}
+
+void usage() {
+  fprintf(stderr,
+    "usage: trace convert [--period-ms MS] [--device N] OUT FILE...\n"
+    "       trace info FILE\n"
+    "       trace dump [--from MS] [--to MS] [--transitions] FILE\n");
+}
+
+}
+
+int main(int argc, char** argv) {
+
+  if (argc < 2) {
+    usage();
+    return 2;
+  }
+  const char* command = argv[1];
+
+  uint32_t periodMs = 10;
+  uint16_t device = 0;
+  uint64_t fromMs = 0;
+  uint64_t toMs = ~(uint64_t)0;
+  bool transitions = false;
+  std::vector<const char*> paths;
+
+  for (int i = 2; i < argc; i++) {
+    const char* option = argv[i];
+    if (strcmp(option, "--transitions") == 0) { transitions = true; continue; }
+    if (option[0] != '-') { paths.push_back(option); continue; }
+    const char* value = i + 1 < argc ? argv[i + 1] : 0;
+    if (!value) { usage(); return 2; }
+    i++;
+    if (strcmp(option, "--period-ms") == 0) periodMs = atoi(value);
+    else if (strcmp(option, "--device") == 0) device = atoi(value);
+    else if (strcmp(option, "--from") == 0) fromMs = strtoull(value, 0, 0);
+    else if (strcmp(option, "--to") == 0) toMs = strtoull(value, 0, 0);
+    else { usage(); return 2; }
+  }
+
+  if (strcmp(command, "convert") == 0 && paths.size() >= 2) {
+    return convert(paths[0], std::vector<const char*>(paths.begin() + 1, paths.end()), periodMs, device);
+  }
+  if (strcmp(command, "info") == 0 && paths.size() == 1) return info(paths[0]);
+  if (strcmp(command, "dump") == 0 && paths.size() == 1) return dump(paths[0], fromMs, toMs, transitions);
+  usage();
+  return 2;
+}
@@ -0,0 +1,72 @@
+#!/bin/sh
+#
+# Flash and RAM used by each example, built with arduino-cli for the
+# Leonardo (ATmega32U4), optionally side by side with another revision.
+#
+#   extras/size.sh [--fqbn FQBN] [--compare REF] [EXAMPLE...]
+#
+# With --compare, REF is checked out into a temporary git worktree and its
+# examples are built the same way; examples missing from either tree are
+# skipped. Set ARDUINO_CLI to use an arduino-cli other than the one on PATH.
+#
+
+set -e
+
+ARDUINO_CLI=${ARDUINO_CLI:-arduino-cli}
+FQBN=arduino:avr:leonardo
+REF=
+EXAMPLES=
+
+while [ $# -gt 0 ]; do
+  case "$1" in
+    --fqbn) FQBN=$2; shift 2 ;;
+    --compare) REF=$2; shift 2 ;;
+    -*) echo "usage: $0 [--fqbn FQBN] [--compare REF] [EXAMPLE...]" >&2; exit 2 ;;
+    *) EXAMPLES="$EXAMPLES $1"; shift ;;
+  esac
+done
+
+if ! command -v "$ARDUINO_CLI" >/dev/null 2>&1; then
+  echo "$0: $ARDUINO_CLI not found (install it and the arduino:avr core)" >&2
+  exit 2
+fi
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+WORK=$(mktemp -d)
+trap 'if [ -n "$REF" ]; then git -C "$ROOT" worktree remove --force "$WORK/ref" 2>/dev/null || true; fi; rm -rf "$WORK"' EXIT
+
+[ -n "$EXAMPLES" ] || EXAMPLES=$(cd "$ROOT/examples" && ls)
+
+# Prints "<example> <flash bytes> <ram bytes>" for every example of the
+# library at $1 that builds.
+sizes() {
+  for example in $EXAMPLES; do
+    [ -d "$1/examples/$example" ] || continue
+    output=$("$ARDUINO_CLI" compile --fqbn "$FQBN" --library "$1" \
+             --build-path "$WORK/build-$example" "$1/examples/$example" 2>&1) || {
+      echo "$example: build failed" >&2
+      continue
+    }
+    flash=$(echo "$output" | sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p')
+    ram=$(echo "$output" | sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p')
+    echo "$example ${flash:-?} ${ram:-?}"
+    rm -rf "$WORK/build-$example"
+  done
+}
+
+sizes "$ROOT" > "$WORK/current"
+
+if [ -z "$REF" ]; then
+  printf '%-24s %8s %8s\n' example flash ram
+  awk '{ printf "%-24s %8s %8s\n", $1, $2, $3 }' "$WORK/current"
+  exit 0
+fi
+
+git -C "$ROOT" worktree add --detach "$WORK/ref" "$REF" >/dev/null 2>&1
+sizes "$WORK/ref" > "$WORK/ref.sizes"
+
+printf '%-24s %8s %8s %8s %8s %8s %8s\n' example flash "$REF" delta ram "$REF" delta
+awk 'NR == FNR { flash[$1] = $2; ram[$1] = $3; next }
+     $1 in flash {
+       printf "%-24s %8s %8s %+8d %8s %8s %+8d\n", $1, $2, flash[$1], $2 - flash[$1], $3, ram[$1], $3 - ram[$1]
+     }' "$WORK/ref.sizes" "$WORK/current"
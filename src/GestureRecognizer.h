@@ -0,0 +1,261 @@
+/*
+ * GestureRecognizer.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef GESTURERECOGNIZER_H_
+#define GESTURERECOGNIZER_H_
+
+#include <stdint.h>
+#include <ProximitySensor.h>
+
+#if !PROXIMITY_FEATURE(STATE_CALLBACK)
+#error GestureRecognizer requires PROXIMITY_FEATURE_STATE_CALLBACK
+#endif
+
+/**
+ * Recognizes taps, double taps, long presses and swipes on an ordered
+ * set of sensors (pads) from their state transitions.
+ *
+ * The recognizer registers itself as the on-state-change callback of
+ * every pad, so it does a constant amount of work per transition and
+ * none per sample. A pad is in contact while its state is at or above
+ * the contact state (TOUCH by default, PROXIMITY for hover gestures).
+ *
+ *   tap          contact no longer than the tap time, reported once the
+ *                double tap gap has passed without a second tap and, if
+ *                a swipe could still start from the pad, the swipe step
+ *                time since the contact
+ *   double tap   two taps on the same pad within the double tap gap
+ *   long press   contact held for the long press time, reported while
+ *                the pad is still held
+ *   swipe        contact moving across at least the minimum number of
+ *                adjacent pads in one direction, each within the swipe
+ *                step time of the previous one, reported when the last
+ *                pad is released; its pads report no taps
+ *
+ * Recognized gestures are queued and read with poll(), which also
+ * reports the gestures that wait on time passing (tap, long press). poll()
+ * only compares the time against the earliest pending deadline unless
+ * one is due, e.g.:
+ *
+ *   ProximitySensor* pads[] = { &left, &center, &right };
+ *   ProximitySensorArray array(pads, 3);
+ *   TGestureRecognizer<3> gestures(pads);
+ *
+ *   void loop() {
+ *     array.update();
+ *     GestureRecognizer::Gesture gesture;
+ *     while (gestures.poll(gesture)) handle(gesture);
+ *   }
+ *
+ * Times are in milliseconds on the clock of the sensors' state durations:
+ * millis(), or the sample time (SampleTimer::ticksToMs() of the last tick)
+ * for paced sensors, in which case the time must be passed to poll().
+ *
+ * Construct the recognizer after the sensors, or call attach() once they
+ * are constructed, as a sensor's constructor clears its callback.
+ */
+class GestureRecognizer {
+
+public:
+
+  enum Type { TAP, DOUBLE_TAP, LONG_PRESS, SWIPE_FORWARD, SWIPE_BACKWARD };
+
+  /**
+   * A recognized gesture. For swipes, pad is the first pad touched and
+   * lastPad the last, in increasing index order for SWIPE_FORWARD; for
+   * other gestures both are the pad. timeMs is the time the gesture
+   * completed.
+   */
+  struct Gesture {
+    Type type;
+    uint8_t pad;
+    uint8_t lastPad;
+    uint32_t timeMs;
+  };
+
+  /**
+   * Per-pad history, stored by TGestureRecognizer.
+   */
+  struct Pad {
+    GestureRecognizer* pOwner;
+    uint32_t contactMs;
+    uint32_t releaseMs;
+    uint8_t index;
+    uint8_t flags;
+  };
+
+  /**
+   * Maximum number of gestures queued between calls to poll().
+   */
+  static const uint8_t QUEUE_SIZE = 4;
+
+  /**
+   * Registers the recognizer with every pad and clears all history.
+   */
+  void attach();
+
+  /**
+   * Reports any gestures that are due at nowMs and returns the oldest
+   * queued gesture, if any.
+   */
+  bool poll(Gesture& gesture, const uint32_t nowMs);
+
+  /**
+   * As poll(Gesture&, uint32_t) at millis().
+   */
+  bool poll(Gesture& gesture);
+
+  /**
+   * Sets the state at or above which a pad is in contact.
+   */
+  void setContactState(const ProximitySensor::State state) {
+    m_contactState = state;
+  }
+
+  ProximitySensor::State getContactState() const {
+    return (ProximitySensor::State)m_contactState;
+  }
+
+  /**
+   * Sets the longest contact that counts as a tap.
+   */
+  uint16_t setTapMs(const uint16_t milliseconds) {
+    return m_tapMs = milliseconds;
+  }
+
+  uint16_t getTapMs() const {
+    return m_tapMs;
+  }
+
+  /**
+   * Sets the longest time from the release of a tap to the next contact
+   * on the same pad for the two to form a double tap. Zero disables double
+   * taps; taps are then reported as soon as their pad can no longer start
+   * a swipe.
+   */
+  uint16_t setDoubleTapGapMs(const uint16_t milliseconds) {
+    return m_doubleTapGapMs = milliseconds;
+  }
+
+  uint16_t getDoubleTapGapMs() const {
+    return m_doubleTapGapMs;
+  }
+
+  /**
+   * Sets the contact time at which a long press is reported.
+   */
+  uint16_t setLongPressMs(const uint16_t milliseconds) {
+    return m_longPressMs = milliseconds;
+  }
+
+  uint16_t getLongPressMs() const {
+    return m_longPressMs;
+  }
+
+  /**
+   * Sets the longest time between contact on one pad and contact on the
+   * next for the two to form part of a swipe.
+   */
+  uint16_t setSwipeStepMs(const uint16_t milliseconds) {
+    return m_swipeStepMs = milliseconds;
+  }
+
+  uint16_t getSwipeStepMs() const {
+    return m_swipeStepMs;
+  }
+
+  /**
+   * Sets the number of pads a swipe must cross, at least two.
+   */
+  uint8_t setSwipeMinPads(const uint8_t pads) {
+    return m_swipeMinPads = pads < 2 ? 2 : pads;
+  }
+
+  uint8_t getSwipeMinPads() const {
+    return m_swipeMinPads;
+  }
+
+  /**
+   * Returns the number of gestures dropped because the queue was full.
+   */
+  uint16_t getOverruns() const {
+    return m_overruns;
+  }
+
+  uint8_t size() const {
+    return m_count;
+  }
+
+protected:
+
+  GestureRecognizer(ProximitySensor* const* ppSensors, Pad* pPads, const uint8_t count);
+
+private:
+
+  static void onStateChange(void* data, ProximitySensor::State from, ProximitySensor::State to, uint32_t timeMs);
+
+  void contact(Pad& pad, const uint32_t timeMs);
+  void release(Pad& pad, const uint32_t timeMs);
+  uint32_t tapDueMs(const Pad& pad) const;
+  void schedule(const uint32_t deadlineMs);
+  void expire(const uint32_t nowMs);
+  void report(const Type type, const uint8_t pad, const uint8_t lastPad, const uint32_t timeMs);
+
+  ProximitySensor* const* m_ppSensors;
+  Pad* m_pPads;
+  uint8_t m_count;
+
+  uint8_t m_contactState;
+  uint16_t m_tapMs;
+  uint16_t m_doubleTapGapMs;
+  uint16_t m_longPressMs;
+  uint16_t m_swipeStepMs;
+  uint8_t m_swipeMinPads;
+
+  // Swipe in progress: first and last pad, pads crossed, direction
+  // (+1, -1 or 0 before the second pad) and time of the last contact.
+  uint8_t m_swipeFirst;
+  uint8_t m_swipeLast;
+  uint8_t m_swipeLength;
+  int8_t m_swipeDirection;
+  uint32_t m_swipeTimeMs;
+
+  // Earliest time a tap or long press may become due.
+  bool m_deadlinePending;
+  uint32_t m_deadlineMs;
+
+  Gesture m_queue[QUEUE_SIZE];
+  uint8_t m_queueHead;
+  uint8_t m_queueCount;
+  uint16_t m_overruns;
+
+};
+
+/**
+ * GestureRecognizer with history for PADS pads, e.g.:
+ *
+ *   ProximitySensor* pads[] = { &left, &center, &right };
+ *   TGestureRecognizer<3> gestures(pads);
+ */
+template<uint8_t PADS> class TGestureRecognizer : public GestureRecognizer {
+public:
+
+  /**
+   * The pointer array must remain valid for the lifetime of the
+   * recognizer and hold PADS sensors in their physical order.
+   */
+  TGestureRecognizer(ProximitySensor* const* ppSensors)
+  : GestureRecognizer(ppSensors, m_pads, PADS) {
+    attach();
+  }
+
+private:
+
+  Pad m_pads[PADS];
+
+};
+
+#endif /* GESTURERECOGNIZER_H_ */
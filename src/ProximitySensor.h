@@ -11,6 +11,90 @@
 #include <stdint.h>
 #include <TAdcPinInput.h>
 
+/**
+ * Mains hum rejection applied by update(), selected at compile time by
+ * defining PROXIMITY_HUM_FILTER before the library is built:
+ *
+ * PROXIMITY_HUM_FILTER_NONE  Samples average exactly 2^resolution pairs.
+ *
+ * PROXIMITY_HUM_FILTER_SYNC  After 2^resolution pairs, acquisition
+ *                            continues until the window spans a whole
+ *                            number of mains periods, so that hum and its
+ *                            harmonics average out. Every update takes at
+ *                            least one mains period.
+ *
+ * PROXIMITY_HUM_FILTER_COMB  Samples acquired through updatePaced() are
+ *                            averaged with the sample from half a mains
+ *                            period earlier, which cancels the mains
+ *                            frequency and its odd harmonics. Requires a
+ *                            SampleTimer rate that is a multiple of twice
+ *                            the mains frequency, up to
+ *                            PROXIMITY_HUM_COMB_MAX_DELAY times (e.g. 100
+ *                            or 200 Hz for 50 Hz mains). Samples from
+ *                            update() without a timer are not filtered.
+ *
+ * PROXIMITY_MAINS_HZ selects 50 or 60 Hz mains.
+ */
+#define PROXIMITY_HUM_FILTER_NONE 0
+#define PROXIMITY_HUM_FILTER_SYNC 1
+#define PROXIMITY_HUM_FILTER_COMB 2
+
+#ifndef PROXIMITY_HUM_FILTER
+#define PROXIMITY_HUM_FILTER PROXIMITY_HUM_FILTER_NONE
+#endif
+
+#ifndef PROXIMITY_MAINS_HZ
+#define PROXIMITY_MAINS_HZ 50
+#endif
+
+#ifndef PROXIMITY_HUM_COMB_MAX_DELAY
+#define PROXIMITY_HUM_COMB_MAX_DELAY 8
+#endif
+
+/**
+ * Optional features, selected at compile time by defining
+ * PROXIMITY_FEATURES before the library is built as the bitwise OR of:
+ *
+ * PROXIMITY_FEATURE_SAMPLE_CALLBACK  setOnSampleCallback(), checked after
+ *                                    every sample pair.
+ *
+ * PROXIMITY_FEATURE_STATE_CALLBACK   setOnStateChangeCallback(). Required
+ *                                    by GestureRecognizer.
+ *
+ * PROXIMITY_FEATURE_TIMEOUTS         Proximity and touch timeouts. Without
+ *                                    them the sensor stays in PROXIMITY or
+ *                                    TOUCH for as long as the samples do.
+ *
+ * PROXIMITY_FEATURE_DEBOUNCE         setDelayMs(). Without it the first
+ *                                    sample above the proximity threshold
+ *                                    enters PROXIMITY.
+ *
+ * PROXIMITY_FEATURE_RESEED           The filter reseed threshold. Without it
+ *                                    samples below the moving average are
+ *                                    filtered like any other; reseed() and
+ *                                    the timeouts still reset the average.
+ *
+ * PROXIMITY_FEATURE_STATISTICS       The state duration getters.
+ *
+ * A disabled feature's code, members and accessors are removed, so using
+ * one is a compile error. All features are enabled by default. Disabling
+ * features changes the sensor layout, so the whole library and the sketch
+ * must be built with the same setting (see extras/features.sh).
+ */
+#define PROXIMITY_FEATURE_SAMPLE_CALLBACK 0x01
+#define PROXIMITY_FEATURE_STATE_CALLBACK 0x02
+#define PROXIMITY_FEATURE_TIMEOUTS 0x04
+#define PROXIMITY_FEATURE_DEBOUNCE 0x08
+#define PROXIMITY_FEATURE_RESEED 0x10
+#define PROXIMITY_FEATURE_STATISTICS 0x20
+#define PROXIMITY_FEATURES_ALL 0x3F
+
+#ifndef PROXIMITY_FEATURES
+#define PROXIMITY_FEATURES PROXIMITY_FEATURES_ALL
+#endif
+
+#define PROXIMITY_FEATURE(feature) ((PROXIMITY_FEATURES & PROXIMITY_FEATURE_##feature) != 0)
+
 /**
  * A class representing a single capacitive proximity sensor.
  * Each sensor requires two dedicated ADC inputs for operation.
@@ -20,10 +104,28 @@
  */
 class ProximitySensor {
 
+  friend class ProximitySensorArray;
+
 public:
 
   enum State { IDLE, PROXIMITY, TOUCH };
 
+  static const uint8_t STATE_COUNT = TOUCH + 1;
+
+  /**
+   * Electrode condition found by diagnose().
+   */
+  enum Health { HEALTHY, OPEN, SHORT_GROUND, SHORT_RAIL, SATURATED };
+
+  /**
+   * The raw ADC readings captured for one sample. The sample value
+   * used by update() is the difference (charged - discharged).
+   */
+  struct SamplePair {
+    uint16_t discharged;
+    uint16_t charged;
+  };
+
   /**
    * Constructs a ProximitySensor instance. The constructor accepts
    * two parameters that describe the pins that will be used to
@@ -47,9 +149,107 @@ public:
    * Updates the current sensor state. This method is called to
    * capture samples, update the moving average and trigger
    * state transitions. Typically called from the main application loop.
+   * Dispatches to the update<RESOLUTION>() instance for the current
+   * resolution setting.
    */
   uint32_t update();
 
+  /**
+   * Updates the sensor as update() does, with the resolution fixed at
+   * compile time rather than taken from setResolution(). The pair count,
+   * loop unrolling, accumulator width (16 bits up to resolution 6) and
+   * final scaling are all resolved by the compiler, e.g.:
+   *
+   *   uint32_t sample = sensor.update<5>();
+   *
+   * Instantiated for resolutions 0 through 10.
+   */
+  template<uint8_t RESOLUTION> uint32_t update();
+
+  /**
+   * Updates the sensor at the rate set by the SampleTimer. Performs an
+   * acquisition and returns true if the timer has ticked since the
+   * previous acquisition; otherwise returns false immediately. The new
+   * sample is returned through the sample parameter.
+   *
+   * Once this method has been called, the state machine, debounce delay,
+   * timeouts and duration getters use time derived from the tick at which
+   * each acquisition was triggered instead of millis(), so their behavior
+   * no longer depends on how long acquisition or the application loop take.
+   * SampleTimer::begin() must be called first.
+   */
+  bool updatePaced(uint32_t& sample);
+
+  /**
+   * Returns the SampleTimer tick that triggered the most recent
+   * updatePaced() acquisition.
+   */
+  uint32_t getSampleTick() const {
+    return m_sampleTick;
+  }
+
+  /**
+   * Returns the number of timer ticks that elapsed without an acquisition
+   * because updatePaced() was not called often enough.
+   */
+  uint32_t getMissedTicks() const {
+    return m_missedTicks;
+  }
+
+  /**
+   * Advances the current acquisition by at most maxPairs sample pairs
+   * and returns. The partial total is kept in the sensor between calls.
+   * Returns true when the acquisition for the current resolution is
+   * complete, in which case the state has been updated exactly as by
+   * update() and the new sample is returned through the sample parameter.
+   * This allows acquisition to be interleaved with other work in a
+   * cooperative loop without using the on-sample callback. The scheduled
+   * health and discharge delay checks run at the start of each
+   * acquisition, as for update(); while the electrode is not HEALTHY, a
+   * call that would start an acquisition returns true with a sample of zero.
+   */
+  bool updateStep(uint32_t& sample, const uint16_t maxPairs);
+
+  /**
+   * Advances the current acquisition until approximately budgetUs
+   * microseconds have been spent. A pair is not started if, at the
+   * average pair time measured during this call, it would end past the
+   * budget; at least one pair is always acquired. Returns true when the
+   * acquisition is complete, as for updateStep().
+   */
+  bool updateForUs(uint32_t& sample, const uint32_t budgetUs);
+
+  /**
+   * Indicates whether a stepped acquisition is in progress.
+   */
+  bool isAcquiring() const {
+    return m_stepCount != 0;
+  }
+
+  /**
+   * Fills a caller-provided buffer with raw sample pairs. The moving
+   * average and sensor state are not changed. No callback is invoked,
+   * so the per-pair overhead is limited to the acquisition itself.
+   * @see TSampleBlockBuffer for double-buffered streaming.
+   */
+  void acquire(SamplePair* pBuffer, size_t count);
+
+  /**
+   * Fills a caller-provided buffer with per-block sums of
+   * (charged - discharged). Each entry sums 2^blockBits sample pairs,
+   * so an entry shifted right by blockBits equals the sample update()
+   * would produce at a resolution of blockBits.
+   */
+  void acquireSums(uint32_t* pBuffer, size_t count, uint8_t blockBits);
+
+  /**
+   * Updates the sensor state from sample pairs captured with acquire().
+   * The pairs are averaged to produce a single sample, which is returned.
+   * Count must be non-zero.
+   */
+  uint32_t update(const SamplePair* pPairs, size_t count);
+
+#if PROXIMITY_FEATURE(SAMPLE_CALLBACK)
   /**
    * The on-sample callback function signature.
    */
@@ -65,6 +265,27 @@ public:
     m_onSampleCallback = cb;
     m_onSampleCallbackData = data;
   }
+#endif
+
+#if PROXIMITY_FEATURE(STATE_CALLBACK)
+  /**
+   * The on-state-change callback function signature. Receives the
+   * registered data pointer, the previous and new state and the time of
+   * the change in the time base of the state durations.
+   */
+  typedef void (*OnStateChangeCallback)(void* data, State from, State to, uint32_t timeMs);
+
+  /**
+   * Registers an optional callback function that will be invoked on
+   * every state transition, from within update(). A sample that moves
+   * the sensor from IDLE directly to TOUCH produces two calls.
+   * @see GestureRecognizer
+   */
+  void setOnStateChangeCallback(OnStateChangeCallback cb, void* data) {
+    m_onStateChangeCallback = cb;
+    m_onStateChangeCallbackData = data;
+  }
+#endif
 
   /**
    * Sets the approximate number of bits of resolution desired for
@@ -80,6 +301,8 @@ public:
    */
   uint8_t setResolution(const uint8_t resolution) {
     m_reseed = true;
+    m_stepTotal = 0;
+    m_stepCount = 0;
     return m_resolution = resolution > 10 ? 10 : resolution;
   }
 
@@ -91,6 +314,248 @@ public:
     return m_resolution;
   }
 
+  /**
+   * Sets the time, in microseconds, for which the S&H cap is grounded
+   * before each sample pair so that charge left from the previous
+   * conversion does not bias the next one. The default of 30 us covers
+   * the worst case observed on noisy boards (e.g. with LED animation);
+   * most boards need less. Values are limited to 1-100 us.
+   * @see calibrateDischargeDelay()
+   */
+  uint8_t setDischargeDelayUs(const uint8_t microseconds);
+
+  /**
+   * Gets the current S&H discharge delay setting.
+   */
+  uint8_t getDischargeDelayUs() const {
+    return m_dischargeDelayUs;
+  }
+
+  /**
+   * Measures the bias introduced by a range of S&H discharge delays,
+   * comparing sample pairs taken with each candidate delay against
+   * interleaved pairs taken with a long reference delay, and selects
+   * the shortest delay that leaves the readings unbiased, that is within
+   * a few standard deviations of the noise measured over the same pairs.
+   * The sensor state is not updated. Takes 64 sample pairs per candidate,
+   * up to 832 when no candidate passes. Returns the selected delay.
+   */
+  uint8_t calibrateDischargeDelay();
+
+  /**
+   * Checks that the current S&H discharge delay still leaves readings
+   * unbiased. If not, the delay is increased to the next calibration step.
+   * If it does and the next shorter step passes as well, the delay is
+   * decreased to that step, so the delay follows the noise both ways.
+   * Returns true if the current delay passed.
+   */
+  bool verifyDischargeDelay();
+
+  /**
+   * Sets the number of update() calls between automatic calls to
+   * verifyDischargeDelay(). Zero (the default) disables verification.
+   */
+  uint16_t setDischargeDelayVerifyInterval(const uint16_t updates) {
+    m_updatesSinceVerify = 0;
+    return m_verifyInterval = updates;
+  }
+
+  /**
+   * Gets the current verification interval setting.
+   */
+  uint16_t getDischargeDelayVerifyInterval() const {
+    return m_verifyInterval;
+  }
+
+  /**
+   * Stores the current S&H discharge delay in EEPROM at the given
+   * address (4 bytes) together with the current ADC profile
+   * (reference, prescaler and high-speed mode).
+   */
+  void saveDischargeDelay(const uint16_t eepromAddress) const;
+
+  /**
+   * Restores an S&H discharge delay stored by saveDischargeDelay().
+   * Returns false, leaving the current setting unchanged, if no valid
+   * record is found or if it was calibrated under a different ADC profile.
+   */
+  bool loadDischargeDelay(const uint16_t eepromAddress);
+
+  /**
+   * Selects single-ended acquisition. Each sample pair normally converts
+   * both the discharged and the charged transfer and uses their
+   * difference. With an interval greater than one, the discharged
+   * reading is measured only on every Nth pair and reused for the pairs
+   * in between, which then convert only the charged transfer. This
+   * nearly doubles the pair rate on electrodes with a stable common
+   * mode. Zero or one (the default) selects differential acquisition.
+   * Raw pairs returned by acquire() carry the reused reference.
+   */
+  uint8_t setDischargedReferenceInterval(const uint8_t pairs);
+
+  /**
+   * Gets the current discharged reference interval setting.
+   */
+  uint8_t getDischargedReferenceInterval() const {
+    return m_dischargedInterval;
+  }
+
+  /**
+   * Forces the discharged reference to be re-measured on the next pair.
+   */
+  void refreshDischargedReference() {
+    m_dischargedAge = 0;
+  }
+
+  /**
+   * Returns the smoothed change, in 1/16 ADC counts, seen in the
+   * discharged reading each time it is re-measured in single-ended mode.
+   * This is the error introduced by reusing the reference and can be
+   * compared with the sample noise to choose an interval.
+   */
+  uint16_t getDischargedReferenceDeviation() const {
+    return m_dischargedDeviation;
+  }
+
+  /**
+   * Number of charge delay timings used by the acquisition jitter.
+   */
+  static const uint8_t JITTER_BINS = 8;
+
+  /**
+   * Shortest charge delay timing, in microseconds. Bin i waits this plus i.
+   */
+  static const uint8_t JITTER_MIN_DELAY_US = 16;
+
+  /**
+   * Enables interference-aware jitter. Each sample pair normally waits a
+   * charge delay picked uniformly from JITTER_BINS timings, which spreads
+   * interference that is synchronous with the acquisition into broadband
+   * noise. In adaptive mode the deviation of each pair from the recent
+   * mean is recorded against the timing it used, and each pair chooses
+   * the quieter of two randomly drawn timings. Periodic interference that
+   * aliases onto particular timings, such as LED PWM, is then avoided
+   * while the remaining timings stay randomized. Enabling or disabling
+   * resets the statistics.
+   */
+  bool setAdaptiveJitter(const bool enable);
+
+  /**
+   * Indicates whether interference-aware jitter is enabled.
+   */
+  bool isAdaptiveJitter() const {
+    return m_adaptiveJitter;
+  }
+
+  /**
+   * Returns the smoothed deviation, in 1/16 ADC counts, recorded for the
+   * given jitter bin in adaptive mode.
+   */
+  uint16_t getJitterNoise(const uint8_t bin) const {
+    return bin < JITTER_BINS ? m_jitterNoise[bin] : 0;
+  }
+
+  /**
+   * Returns the charge delay, in microseconds, of the quietest jitter bin.
+   */
+  uint8_t getQuietestJitterDelayUs() const;
+
+  /**
+   * Acquires a short contiguous run of sample pairs and returns the
+   * frequency, in Hz, of the dominant periodic component found by
+   * autocorrelation, or zero if there is none. Intended for mains hum at
+   * 50 or 60 Hz and its low harmonics; lags are quantized to two pair
+   * times (about 0.55 ms), so above a few hundred Hz a subharmonic may be
+   * reported, and components above half the pair rate appear at their
+   * alias. Periods longer than about 26 ms, below about 40 Hz, are not
+   * searched. A peak must stand well clear of the correlation noise would
+   * produce, so uncorrelated noise reports zero. Takes 192 pairs and does
+   * not update the sensor state.
+   */
+  uint16_t detectInterference();
+
+  /**
+   * Returns the result of the last call to detectInterference().
+   */
+  uint16_t getInterferenceHz() const {
+    return m_interferenceHz;
+  }
+
+  /**
+   * Checks the electrode with a few raw sample pairs and classifies it:
+   *
+   *   SHORT_GROUND  every reading at the bottom of the ADC range; the
+   *                 sensor pin cannot be charged.
+   *   SHORT_RAIL    every reading at the top of the range; the sensor pin
+   *                 cannot be discharged.
+   *   SATURATED     some readings at either end of the range, so the
+   *                 difference is clipped and no longer follows the
+   *                 electrode.
+   *   OPEN          mean (charged - discharged) below the open threshold,
+   *                 as when only the pin is left after a cable comes loose.
+   *
+   * When a HEALTHY sensor is found in any other condition, it is released
+   * to IDLE directly: an active state ends with the state callback and a
+   * new IDLE start time, any debounce delay is cleared and the moving
+   * average, which is not adapted toward the fault readings, is marked for
+   * reseeding. Every update method then returns zero without acquiring
+   * until a later check finds the sensor HEALTHY again, and the first
+   * sample after that reseeds the average. Takes four sample pairs.
+   * Returns the new condition.
+   * @see setHealthCheckInterval(const uint16_t updates)
+   */
+  Health diagnose();
+
+  /**
+   * Returns the condition found by the last diagnose(). HEALTHY until the
+   * first check.
+   */
+  Health getHealth() const {
+    return m_health;
+  }
+
+  /**
+   * Indicates whether the last diagnose() found the electrode HEALTHY.
+   */
+  bool isHealthy() const {
+    return m_health == HEALTHY;
+  }
+
+  /**
+   * Sets the number of update() calls between automatic calls to
+   * diagnose(), counting the calls skipped while the sensor is not
+   * HEALTHY. ProximitySensorArray::update() follows the same schedule.
+   * Zero (the default) disables the checks.
+   */
+  uint16_t setHealthCheckInterval(const uint16_t updates) {
+    m_updatesSinceHealthCheck = 0;
+    return m_healthCheckInterval = updates;
+  }
+
+  /**
+   * Gets the current health check interval setting.
+   */
+  uint16_t getHealthCheckInterval() const {
+    return m_healthCheckInterval;
+  }
+
+  /**
+   * Sets the mean (charged - discharged), in ADC counts, below which
+   * diagnose() reports an OPEN electrode. The default of 16 counts suits
+   * pads and wires of a few square centimeters; small electrodes may
+   * need less. Values are limited to 1023.
+   */
+  uint16_t setOpenThreshold(const uint16_t counts) {
+    return m_openThreshold = counts > 1023 ? 1023 : counts;
+  }
+
+  /**
+   * Gets the current open threshold setting.
+   */
+  uint16_t getOpenThreshold() const {
+    return m_openThreshold;
+  }
+
   /**
    * Sets the moving average adaptation rate. This value is used
    * as a coefficient in the infinite impulse response (IIR) filter
@@ -114,6 +579,7 @@ public:
     return m_filterAdaptationRate;
   }
 
+#if PROXIMITY_FEATURE(RESEED)
   /**
    * Sets the moving average filter reseed threshold. This
    * value defines a threshold relative to the current moving average
@@ -133,6 +599,7 @@ public:
   uint8_t getFilterReseedThreshold() const {
     return m_filterReseedThreshold;
   }
+#endif
 
   /**
    * Sets the threshold at which the sensor will enter the PROXIMITY
@@ -196,6 +663,7 @@ public:
     return m_releaseThreshold;
   }
 
+#if PROXIMITY_FEATURE(DEBOUNCE)
   /**
    * Sets a time that must pass with after the sensor begins
    * receiving samples greater than the proximity threshold before
@@ -215,13 +683,22 @@ public:
   }
 
   /**
-   * Returns the time since the sensor entered into the
-   * temporary delay state.
+   * Indicates whether the sensor is in the temporary delay state.
+   */
+  bool isDelaying() const {
+    return m_delaying;
+  }
+
+  /**
+   * Returns the time at which the sensor entered into the
+   * temporary delay state. Only meaningful while isDelaying().
    */
   uint32_t getDelayStartTimeMs() const {
     return m_delayStartTimeMs;
   }
+#endif
 
+#if PROXIMITY_FEATURE(TIMEOUTS)
   /**
    * Sets the maximum amount of time that the sensor will be
    * allowed reside in the PROXIMITY state. A timeout should be used
@@ -229,14 +706,14 @@ public:
    * environment may occur while the sensor is active.
    */
   uint32_t setProximityTimeoutMs(const uint32_t& milliseconds) {
-    return m_proximityTimeoutMs = milliseconds;
+    return m_stateTimeoutMs[PROXIMITY - 1] = milliseconds;
   }
 
   /**
    * Gets the current proximity timeout setting.
    */
   uint32_t getProximityTimeoutMs() const {
-    return m_proximityTimeoutMs;
+    return m_stateTimeoutMs[PROXIMITY - 1];
   }
 
   /**
@@ -246,15 +723,16 @@ public:
    * environment may occur while the sensor is active.
    */
  uint32_t setTouchTimeoutMs(const uint32_t& milliseconds) {
-    return m_touchTimeoutMs = milliseconds;
+    return m_stateTimeoutMs[TOUCH - 1] = milliseconds;
   }
 
  /**
   * Gets the current touch timeout setting.
   */
   uint32_t getTouchTimeoutMs() const {
-    return m_touchTimeoutMs;
+    return m_stateTimeoutMs[TOUCH - 1];
   }
+#endif
 
   /**
    * Gets the moving average of incoming samples produced by
@@ -285,6 +763,7 @@ public:
     return m_state == TOUCH;
   }
 
+#if PROXIMITY_FEATURE(STATISTICS)
   /**
    * Returns the number of milliseconds during which the sensor
    * has currently resided in the IDLE state.
@@ -302,6 +781,7 @@ public:
    * has currently resided in the TOUCH state.
    */
   uint32_t getTouchDurationMs() const;
+#endif
 
   /**
    * Forces a reset of the internal IIR moving average filter.
@@ -312,14 +792,63 @@ public:
 
 protected:
 
+  /**
+   * Applies one sample to the filter and the state machine. Transitions
+   * are looked up in a table indexed by state and by the band the sample
+   * falls in relative to the thresholds (see ProximitySensor.cpp).
+   */
   uint32_t update(uint32_t sample);
 
   uint32_t updateMovingAverage(uint32_t sample);
 
   static uint16_t getAdcSample();
 
+  static void randomDelay();
+
+  static void jitterDelay(const uint8_t bin);
+
+  static uint8_t getAdcProfile();
+
+  uint32_t currentTimeMs() const;
+
 private:
 
+  uint16_t acquireDischarged();
+
+  uint16_t acquireCharged();
+
+  void acquireDifferentialPair(SamplePair& pair);
+
+  void acquireSingleEndedPair(SamplePair& pair);
+
+  void acquirePair(SamplePair& pair);
+
+  void chargeDelay();
+
+  void selectJitterBin();
+
+  void recordJitterNoise(const int16_t difference);
+
+  int16_t acquireDifference();
+
+  void verifyIfDue();
+
+  bool checkHealthIfDue();
+
+  bool prepareUpdate();
+
+  uint32_t filterHum(uint32_t sample);
+
+  typedef uint32_t (*UpdateFunction)(ProximitySensor&);
+
+  template<uint8_t RESOLUTION> static uint32_t updateWithResolution(ProximitySensor& sensor);
+
+  static const UpdateFunction s_updateTable[];
+
+  uint32_t completeStep();
+
+  bool isDischargeUnbiased(const uint16_t loops, const uint8_t pairs);
+
   AdcPinInput* m_pReferencePin;
   AdcPinInput* m_pSensorPin;
 
@@ -327,24 +856,36 @@ private:
 
   uint8_t m_filterAdaptationRate;
 
+#if PROXIMITY_FEATURE(RESEED)
   uint8_t m_filterReseedThreshold;
+#endif
+
+#if PROXIMITY_FEATURE(TIMEOUTS) || PROXIMITY_FEATURE(STATISTICS)
+  /**
+   * Time each state was last entered, indexed by State.
+   */
+  uint32_t m_stateStartTimeMs[STATE_COUNT];
+#endif
 
-  uint32_t m_idleStartTimeMs;
+#if PROXIMITY_FEATURE(TIMEOUTS)
+  /**
+   * Timeout of each state other than IDLE, indexed by State - 1.
+   */
+  uint32_t m_stateTimeoutMs[STATE_COUNT - 1];
+#endif
 
   uint8_t m_proximityThreshold;
 
-  uint32_t m_proximityTimeoutMs;
-  uint32_t m_proximityStartTimeMs;
-
   uint8_t m_touchThreshold;
 
-  uint32_t m_touchTimeoutMs;
-  uint32_t m_touchStartTimeMs;
-
   uint8_t m_releaseThreshold;
 
+#if PROXIMITY_FEATURE(DEBOUNCE)
   uint32_t m_delayMs;
   uint32_t m_delayStartTimeMs;
+  // Separate from the start time, which may legitimately be zero.
+  bool m_delaying;
+#endif
 
   uint32_t m_movingAverage;
 
@@ -354,8 +895,55 @@ private:
 
   size_t m_reseedSampleCount;
 
+  uint8_t m_dischargeDelayUs;
+  uint16_t m_dischargeDelayLoops;
+  uint16_t m_verifyInterval;
+  uint16_t m_updatesSinceVerify;
+
+  uint8_t m_dischargedInterval;
+  uint8_t m_dischargedAge;
+  bool m_dischargedSeeded;
+  uint16_t m_dischargedReference;
+  uint16_t m_dischargedDeviation;
+
+  bool m_adaptiveJitter;
+  uint8_t m_jitterBin;
+  int16_t m_jitterMean;
+  int16_t m_jitterNoise[JITTER_BINS];
+  uint16_t m_interferenceHz;
+
+  Health m_health;
+  uint16_t m_healthCheckInterval;
+  uint16_t m_updatesSinceHealthCheck;
+  uint16_t m_openThreshold;
+
+#if PROXIMITY_HUM_FILTER == PROXIMITY_HUM_FILTER_COMB
+  uint32_t m_combHistory[PROXIMITY_HUM_COMB_MAX_DELAY];
+  uint8_t m_combDelay;
+  uint8_t m_combIndex;
+  uint8_t m_combCount;
+#endif
+
+  uint32_t m_stepTotal;
+  uint16_t m_stepCount;
+
+  // (charged - discharged) of the current ProximitySensorArray pair
+  int16_t m_arrayDifference;
+
+  bool m_paced;
+  uint32_t m_sampleTick;
+  uint32_t m_missedTicks;
+  uint32_t m_sampleTimeMs;
+
+#if PROXIMITY_FEATURE(SAMPLE_CALLBACK)
   void* m_onSampleCallbackData;
   OnSampleCallback m_onSampleCallback;
+#endif
+
+#if PROXIMITY_FEATURE(STATE_CALLBACK)
+  void* m_onStateChangeCallbackData;
+  OnStateChangeCallback m_onStateChangeCallback;
+#endif
 
 };
 
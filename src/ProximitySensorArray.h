@@ -0,0 +1,105 @@
+/*
+ * ProximitySensorArray.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef PROXIMITYSENSORARRAY_H_
+#define PROXIMITYSENSORARRAY_H_
+
+#include <stdint.h>
+#include <ProximitySensor.h>
+
+/**
+ * Acquires samples for a group of ProximitySensor instances at once.
+ *
+ * ProximitySensor::update() pays the S&H discharge delay and two random
+ * charge delays for every sample pair of every sensor. The array instead
+ * discharges (or charges) every electrode at the same time, waits a single
+ * random settle window and then converts each channel in turn, paying only
+ * the short S&H transfer per channel. With N electrodes this removes about
+ * (N-1)/N of the fixed delay per pair.
+ *
+ * Electrodes float while earlier channels are converted, so leakage has
+ * slightly longer to act on later channels. Interrupts are disabled for one
+ * half of a pair at a time, roughly 110 us per channel; keep arrays to eight
+ * or fewer sensors so that a millis() tick is not lost.
+ *
+ * Each channel's result goes through the same processing as the sensor
+ * updated on its own: adaptive jitter, the on-sample callback (once per
+ * pair), the scheduled health and discharge delay checks, the hum filter
+ * and the state machine. With adaptive jitter the shared settle window
+ * takes the timing that is quietest over all adaptive sensors.
+ * Single-ended acquisition and the PROXIMITY_HUM_FILTER_SYNC window are
+ * not used in array mode.
+ *
+ * Sensors whose last ProximitySensor::diagnose() did not find them
+ * HEALTHY are not driven or converted, so a dead channel costs no
+ * acquisition time; each sensor's health check interval applies.
+ *
+ * The sensors keep their own thresholds, filters and state. The array's
+ * resolution applies to all of them; their individual resolution settings
+ * are not used in array mode. Sensors may share a reference pin.
+ */
+class ProximitySensorArray {
+
+public:
+
+  /**
+   * Constructs an array over the given sensors. The pointer array must
+   * remain valid for the lifetime of the array, e.g.:
+   *
+   *   ProximitySensor* sensors[] = { &left, &center, &right };
+   *   ProximitySensorArray array(sensors, 3);
+   */
+  ProximitySensorArray(ProximitySensor* const* ppSensors, const uint8_t count);
+
+  /**
+   * Acquires one sample for every sensor and updates each sensor's state.
+   * If pSamples is given, it receives the new sample of each sensor, or
+   * zero for a sensor that is not HEALTHY.
+   */
+  void update(uint32_t* pSamples = 0);
+
+  /**
+   * Sets the resolution used for all sensors in the array.
+   * @see ProximitySensor::setResolution(const uint8_t resolution)
+   */
+  uint8_t setResolution(const uint8_t resolution);
+
+  /**
+   * Gets the current resolution setting.
+   */
+  uint8_t getResolution() const {
+    return m_resolution;
+  }
+
+  /**
+   * Returns the number of sensors in the array.
+   */
+  uint8_t size() const {
+    return m_count;
+  }
+
+  /**
+   * Returns the sensor at the given index.
+   */
+  ProximitySensor& operator[](const uint8_t index) const {
+    return *m_ppSensors[index];
+  }
+
+private:
+
+  uint8_t selectJitterBin();
+
+  void settle(const uint8_t bin);
+
+  void acquirePair();
+
+  ProximitySensor* const* m_ppSensors;
+  uint8_t m_count;
+  uint8_t m_resolution;
+
+};
+
+#endif /* PROXIMITYSENSORARRAY_H_ */
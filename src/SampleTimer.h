@@ -0,0 +1,110 @@
+/*
+ * SampleTimer.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SAMPLETIMER_H_
+#define SAMPLETIMER_H_
+
+#include <stdint.h>
+
+/**
+ * A hardware timer (Timer3) that paces sensor acquisitions at a fixed rate.
+ * The timer interrupt only advances a tick counter. Sensors that are updated
+ * through ProximitySensor::updatePaced() acquire once per tick and tag each
+ * result with the tick that triggered it, so the effective sample rate and
+ * all state machine timing follow the timer rather than the time taken by
+ * acquisition and the rest of the application loop.
+ *
+ * Filter constants can be given in time units and converted at compile time:
+ *
+ *   sensor.setFilterAdaptationRate(SampleTimer::AdaptationRate<200, 5000>::value);
+ *
+ * selects the adaptation rate that gives a 5 second time constant at 200 Hz.
+ *
+ * The Timer3 compare interrupt handler is not compiled into the library, so
+ * that sketches which do not pace their sensors leave Timer3 (and its
+ * vector) to the core, e.g. for tone(). A sketch that uses the timer
+ * installs the handler by defining PROXIMITY_SAMPLE_TIMER_ISR before
+ * including this header, in exactly one source file:
+ *
+ *   #define PROXIMITY_SAMPLE_TIMER_ISR
+ *   #include <SampleTimer.h>
+ */
+class SampleTimer {
+
+public:
+
+  /**
+   * Starts the timer at the given rate (1 Hz to 65535 Hz).
+   * Returns the rate actually configured, which may differ from the
+   * requested rate by the rounding of the timer compare value.
+   * A rate of zero stops the timer as end() does and returns zero.
+   */
+  static uint16_t begin(const uint16_t rateHz);
+
+  /**
+   * Stops the timer and disables its interrupt.
+   */
+  static void end();
+
+  /**
+   * Gets the configured tick rate.
+   */
+  static uint16_t getRateHz() {
+    return s_rateHz;
+  }
+
+  /**
+   * Returns the number of ticks since begin() was called.
+   */
+  static uint32_t getTick();
+
+  /**
+   * Converts a tick count to milliseconds at the configured rate.
+   */
+  static uint32_t ticksToMs(const uint32_t ticks);
+
+  /**
+   * Compile-time conversion of an IIR filter time constant into the
+   * adaptation rate (fraction of 256) accepted by
+   * ProximitySensor::setFilterAdaptationRate(). The result is clamped to
+   * the range 1-255.
+   */
+  template<uint16_t RATE_HZ, uint32_t TIME_CONSTANT_MS> struct AdaptationRate {
+    static const uint32_t SAMPLES = (uint32_t)RATE_HZ * TIME_CONSTANT_MS;
+    static const uint32_t RATE = (256000UL + SAMPLES / 2) / SAMPLES;
+    static const uint8_t value = RATE < 1 ? 1 : RATE > 255 ? 255 : RATE;
+  };
+
+  /**
+   * Compile-time conversion of a duration into ticks, rounded up.
+   */
+  template<uint16_t RATE_HZ, uint32_t MILLISECONDS> struct Ticks {
+    static const uint32_t value = ((uint32_t)RATE_HZ * MILLISECONDS + 999) / 1000;
+  };
+
+  /**
+   * Advances the tick count. Called from the timer interrupt.
+   */
+  static void onTick() {
+    s_tick++;
+  }
+
+private:
+
+  static volatile uint32_t s_tick;
+  static uint16_t s_rateHz;
+
+};
+
+#ifdef PROXIMITY_SAMPLE_TIMER_ISR
+#include <avr/interrupt.h>
+
+ISR(TIMER3_COMPA_vect) {
+  SampleTimer::onTick();
+}
+#endif
+
+#endif /* SAMPLETIMER_H_ */
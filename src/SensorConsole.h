@@ -0,0 +1,202 @@
+/*
+ * SensorConsole.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SENSORCONSOLE_H_
+#define SENSORCONSOLE_H_
+
+#include <stdint.h>
+#include <Stream.h>
+#include <ProximitySensor.h>
+
+/**
+ * Binary tuning and telemetry protocol for a set of sensors over a Stream
+ * (usually Serial), so that tunables can be changed at runtime from the
+ * host console (extras/host/console) instead of by reflashing, e.g.:
+ *
+ *   ProximitySensor sensor(...);
+ *   SensorConsole console(Serial, sensor);
+ *
+ *   void loop() {
+ *     uint32_t sample = sensor.update();
+ *     console.poll(&sample);
+ *   }
+ *
+ * Every message is a frame:
+ *
+ *   SYNC  length  type  payload[length]  check
+ *
+ * where check is the XOR of length, type and the payload. Multi-byte
+ * values are little endian. The host sends commands; the device answers
+ * each with a reply of type (command | REPLY) or an ERROR, and sends
+ * TELEMETRY frames unprompted while subscribed.
+ *
+ *   PING       -                       version, sensors, PROXIMITY_FEATURES
+ *   GET        sensor, parameter       sensor, parameter, value (4)
+ *   SET        sensor, parameter,      sensor, parameter, value (4) as
+ *              value (4)               returned by the setter
+ *   SUBSCRIBE  sensor mask (2),        sensor mask (2), decimation (2)
+ *              decimation (2)
+ *   RESEED     sensor                  sensor
+ *   CALIBRATE  sensor                  sensor, DISCHARGE_DELAY_US, value (4)
+ *   TELEMETRY                          sensor, state, time ms (2),
+ *                                      sample (2), average (2)
+ *   ERROR                              command, Error
+ *
+ * Sensor ALL_SENSORS applies SET, RESEED and CALIBRATE to every sensor and
+ * replies with the last sensor's value. A subscription sends one TELEMETRY
+ * frame per sensor in the mask (sensors 0 to 15) every decimation calls to
+ * poll(); zero unsubscribes. Telemetry frames that do not fit in the
+ * stream's write buffer are dropped rather than waited for.
+ *
+ * poll() never blocks on input. With no subscription and no input pending
+ * it costs one call to available().
+ */
+class SensorConsole {
+
+public:
+
+  static const uint8_t PROTOCOL_VERSION = 1;
+
+  static const uint8_t SYNC = 0xA5;
+
+  /**
+   * Largest command payload; longer frames are rejected.
+   */
+  static const uint8_t MAX_PAYLOAD = 6;
+
+  static const uint8_t ALL_SENSORS = 0xFF;
+
+  enum Command {
+    PING = 0x01,
+    GET = 0x02,
+    SET = 0x03,
+    SUBSCRIBE = 0x04,
+    RESEED = 0x05,
+    CALIBRATE = 0x06
+  };
+
+  enum Message {
+    REPLY = 0x80,
+    TELEMETRY = 0x40,
+    ERROR = 0x7F
+  };
+
+  /**
+   * Tunables, by the ProximitySensor setter they map to. Parameters from
+   * READ_ONLY up can only be read. Parameters of features compiled out
+   * of the library (see PROXIMITY_FEATURES) are UNKNOWN_PARAMETER.
+   */
+  enum Parameter {
+    RESOLUTION = 0x00,
+    FILTER_ADAPTATION_RATE = 0x01,
+    FILTER_RESEED_THRESHOLD = 0x02,
+    PROXIMITY_THRESHOLD = 0x03,
+    TOUCH_THRESHOLD = 0x04,
+    RELEASE_THRESHOLD = 0x05,
+    DELAY_MS = 0x06,
+    PROXIMITY_TIMEOUT_MS = 0x07,
+    TOUCH_TIMEOUT_MS = 0x08,
+    DISCHARGE_DELAY_US = 0x09,
+    DISCHARGE_DELAY_VERIFY_INTERVAL = 0x0A,
+    DISCHARGED_REFERENCE_INTERVAL = 0x0B,
+    ADAPTIVE_JITTER = 0x0C,
+    HEALTH_CHECK_INTERVAL = 0x0D,
+    OPEN_THRESHOLD = 0x0E,
+    READ_ONLY = 0x40,
+    STATE = 0x40,
+    MOVING_AVERAGE = 0x41,
+    DISCHARGED_REFERENCE_DEVIATION = 0x42,
+    QUIETEST_JITTER_DELAY_US = 0x43,
+    MISSED_TICKS = 0x44,
+    HEALTH = 0x45
+  };
+
+  enum Error {
+    BAD_CHECK = 0x01,
+    BAD_LENGTH = 0x02,
+    UNKNOWN_COMMAND = 0x03,
+    BAD_SENSOR = 0x04,
+    UNKNOWN_PARAMETER = 0x05,
+    PARAMETER_READ_ONLY = 0x06
+  };
+
+  /**
+   * Serves count sensors. The pointer array must remain valid for the
+   * lifetime of the console.
+   */
+  SensorConsole(Stream& stream, ProximitySensor* const* ppSensors, const uint8_t count);
+
+  /**
+   * Serves a single sensor.
+   */
+  SensorConsole(Stream& stream, ProximitySensor& sensor);
+
+  /**
+   * Handles any commands received and sends telemetry when due. Call once
+   * per sensor update, with the samples returned by the update (one per
+   * sensor, e.g. from ProximitySensorArray::update()) or with none, in
+   * which case telemetry reports a sample of zero.
+   */
+  void poll(const uint32_t* pSamples = 0);
+
+  uint16_t getTelemetryMask() const {
+    return m_telemetryMask;
+  }
+
+  uint16_t getTelemetryDecimation() const {
+    return m_telemetryDecimation;
+  }
+
+  /**
+   * Returns the number of telemetry frames dropped because the stream
+   * could not accept them.
+   */
+  uint16_t getTelemetryDropped() const {
+    return m_telemetryDropped;
+  }
+
+  /**
+   * Returns the number of received frames rejected for their length or
+   * check byte.
+   */
+  uint16_t getFrameErrors() const {
+    return m_frameErrors;
+  }
+
+private:
+
+  enum ReceiveState { RECEIVE_SYNC, RECEIVE_LENGTH, RECEIVE_TYPE, RECEIVE_PAYLOAD, RECEIVE_CHECK };
+
+  void receive();
+  void execute();
+  bool get(ProximitySensor& sensor, const uint8_t parameter, uint32_t& value);
+  bool set(ProximitySensor& sensor, const uint8_t parameter, uint32_t& value);
+  void sendTelemetry(const uint32_t* pSamples);
+  void sendValue(const uint8_t sensor, const uint8_t parameter, const uint32_t value);
+  void sendError(const uint8_t error);
+  void send(const uint8_t type, const uint8_t* pPayload, const uint8_t length);
+
+  Stream& m_stream;
+  ProximitySensor* m_pSensor;
+  ProximitySensor* const* m_ppSensors;
+  uint8_t m_count;
+
+  uint8_t m_receiveState;
+  uint8_t m_receiveLength;
+  uint8_t m_receiveIndex;
+  uint8_t m_receiveCheck;
+  uint8_t m_receiveType;
+  uint8_t m_receivePayload[MAX_PAYLOAD];
+
+  uint16_t m_telemetryMask;
+  uint16_t m_telemetryDecimation;
+  uint16_t m_telemetryCountdown;
+  uint16_t m_telemetryDropped;
+  uint16_t m_frameErrors;
+
+};
+
+#endif /* SENSORCONSOLE_H_ */
@@ -9,269 +9,128 @@
 #define ADCPININPUT_H_
 
 #include <stdint.h>
+#include <avr/io.h>
 #include <avr/pgmspace.h>
 #include <impl/AdcPinInput.h>
 #include <impl/Pin.h>
 
+/**
+ * Port registers, returned by inline accessors so that pin operations
+ * compile to single bit instructions on constant addresses.
+ */
 struct PortB {
-  static volatile uint8_t& PORT;
-  static volatile uint8_t& PIN;
-  static volatile uint8_t& DDR;
+  static volatile uint8_t& port() { return PORTB; }
+  static volatile uint8_t& pin() { return PINB; }
+  static volatile uint8_t& ddr() { return DDRB; }
 };
 
 struct PortC {
-  static volatile uint8_t& PORT;
-  static volatile uint8_t& PIN;
-  static volatile uint8_t& DDR;
+  static volatile uint8_t& port() { return PORTC; }
+  static volatile uint8_t& pin() { return PINC; }
+  static volatile uint8_t& ddr() { return DDRC; }
 };
 
 struct PortD {
-  static volatile uint8_t& PORT;
-  static volatile uint8_t& PIN;
-  static volatile uint8_t& DDR;
+  static volatile uint8_t& port() { return PORTD; }
+  static volatile uint8_t& pin() { return PIND; }
+  static volatile uint8_t& ddr() { return DDRD; }
 };
 
 struct PortE {
-  static volatile uint8_t& PORT;
-  static volatile uint8_t& PIN;
-  static volatile uint8_t& DDR;
+  static volatile uint8_t& port() { return PORTE; }
+  static volatile uint8_t& pin() { return PINE; }
+  static volatile uint8_t& ddr() { return DDRE; }
 };
 
 struct PortF {
-  static volatile uint8_t& PORT;
-  static volatile uint8_t& PIN;
-  static volatile uint8_t& DDR;
-};
-
-/**
- * Extends AdcPinInput class to provide a base template declaration for
- * pin-specific template specialization.
- * The various specializations can be treated as singletons and
- * accessed via the static instance() method defined by each.
- */
-template<int MUX_INDEX> class TAdcPinInput : public AdcPinInput {
+  static volatile uint8_t& port() { return PORTF; }
+  static volatile uint8_t& pin() { return PINF; }
+  static volatile uint8_t& ddr() { return DDRF; }
 };
 
 /**
- * Template specialization for pin 0.
+ * ATmega32U4 ADC input pins by ADC channel number. Port and BIT locate
+ * the pin, MUX is the MUX5:0 value that selects it and DIDR/DIDR_BIT
+ * name the digital input disable register (DIDR0 or DIDR2) and bit.
+ * Only the channels defined here can be used with TAdcPinInput.
  */
-template<> class TAdcPinInput<0> : public AdcPinInput {
-public:
-
-  typedef TPin<PortF, PF0> PinType;
-
-  TAdcPinInput()
-  : AdcPinInput(0) {
-    DIDR0 |= _BV(PF0);
-  }
+template<int ADC_CHANNEL> struct TAdcPinTraits;
 
-  virtual ~TAdcPinInput() {}
-
-  Pin& pin() { return m_pin; }
-
-  /**
-   * Returns singleton instance of this specialization of the TAdcPinInput template.
-   */
-  static TAdcPinInput& instance() {
-    return s_singleton;
-  }
-
-protected:
-  PinType m_pin;
-  static TAdcPinInput s_singleton;
+template<> struct TAdcPinTraits<0> {
+  typedef PortF Port;
+  static const uint8_t BIT = PF0, MUX = 0b000000, DIDR = 0, DIDR_BIT = 0;
 };
 
-template<> class TAdcPinInput<1> : public AdcPinInput {
-public:
-
-  typedef TPin<PortF,PF1> PinType;
-
-  TAdcPinInput()
-  : AdcPinInput(1) {
-    DIDR0 |= _BV(PF1);
-  }
-
-  virtual ~TAdcPinInput() {}
-
-  Pin& pin() { return m_pin; }
-
-  /**
-   * Returns singleton instance of this specialization of the TAdcPinInput template.
-   */
-  static TAdcPinInput& instance() {
-    return s_singleton;
-  }
-
-protected:
-  PinType m_pin;
-  static TAdcPinInput s_singleton;
+template<> struct TAdcPinTraits<1> {
+  typedef PortF Port;
+  static const uint8_t BIT = PF1, MUX = 0b000001, DIDR = 0, DIDR_BIT = 1;
 };
 
-template<> class TAdcPinInput<6> : public AdcPinInput {
-public:
-
-  typedef TPin<PortF,PF6> PinType;
-
-  TAdcPinInput()
-  : AdcPinInput(6) {
-    DIDR0 |= _BV(PF6);
-  }
-
-  virtual ~TAdcPinInput() {}
-
-  Pin& pin() { return m_pin; }
-
-  /**
-   * Returns singleton instance of this specialization of the TAdcPinInput template.
-   */
-  static TAdcPinInput& instance() {
-    return s_singleton;
-  }
-
-protected:
-  PinType m_pin;
-  static TAdcPinInput s_singleton;
+template<> struct TAdcPinTraits<4> {
+  typedef PortF Port;
+  static const uint8_t BIT = PF4, MUX = 0b000100, DIDR = 0, DIDR_BIT = 4;
 };
 
-template<> class TAdcPinInput<7> : public AdcPinInput {
-public:
-  typedef TPin<PortF,PF7> PinType;
-
-  TAdcPinInput()
-  : AdcPinInput(7) {
-    DIDR0 |= _BV(PF7);
-  }
-
-  virtual ~TAdcPinInput() {}
-
-  Pin& pin() { return m_pin; }
-
-  /**
-   * Returns singleton instance of this specialization of the TAdcPinInput template.
-   */
-  static TAdcPinInput& instance() {
-    return s_singleton;
-  }
-
-protected:
-  PinType m_pin;
-  static TAdcPinInput s_singleton;
+template<> struct TAdcPinTraits<5> {
+  typedef PortF Port;
+  static const uint8_t BIT = PF5, MUX = 0b000101, DIDR = 0, DIDR_BIT = 5;
 };
 
-
-template<> class TAdcPinInput<8> : public AdcPinInput {
-public:
-  typedef TPin<PortD,PD4> PinType;
-
-  TAdcPinInput()
-  : AdcPinInput(0b100000) {
-    DDRD &= ~(_BV(PD4));
-    DIDR2 |= _BV(0);
-  }
-
-  virtual ~TAdcPinInput() {}
-
-  Pin& pin() { return m_pin; }
-
-  /**
-   * Returns singleton instance of this specialization of the TAdcPinInput template.
-   */
-  static TAdcPinInput& instance() {
-    return s_singleton;
-  }
-
-protected:
-  PinType m_pin;
-  static TAdcPinInput s_singleton;
+template<> struct TAdcPinTraits<6> {
+  typedef PortF Port;
+  static const uint8_t BIT = PF6, MUX = 0b000110, DIDR = 0, DIDR_BIT = 6;
 };
 
-template<> class TAdcPinInput<9> : public AdcPinInput {
-public:
-  typedef TPin<PortD,PD6> PinType;
-
-  TAdcPinInput()
-  : AdcPinInput(0b100001) {
-    DDRD &= ~(_BV(PD6));
-    DIDR2 |= _BV(1);
-  }
-
-  virtual ~TAdcPinInput() {}
-
-  Pin& pin() { return m_pin; }
-
-  /**
-   * Returns singleton instance of this specialization of the TAdcPinInput template.
-   */
-  static TAdcPinInput& instance() {
-    return s_singleton;
-  }
-
-protected:
-  PinType m_pin;
-  static TAdcPinInput s_singleton;
+template<> struct TAdcPinTraits<7> {
+  typedef PortF Port;
+  static const uint8_t BIT = PF7, MUX = 0b000111, DIDR = 0, DIDR_BIT = 7;
 };
 
-template<> class TAdcPinInput<10> : public AdcPinInput {
-public:
-  typedef TPin<PortD,PD7> PinType;
-
-  TAdcPinInput()
-  : AdcPinInput(0b100010) {
-    DDRD &= ~(_BV(PD7));
-    DIDR2 |= _BV(2);
-  }
-
-  virtual ~TAdcPinInput() {}
-
-  Pin& pin() { return m_pin; }
-
-  /**
-   * Returns singleton instance of this specialization of the TAdcPinInput template.
-   */
-  static TAdcPinInput& instance() {
-    return s_singleton;
-  }
-
-protected:
-  PinType m_pin;
-  static TAdcPinInput s_singleton;
+template<> struct TAdcPinTraits<8> {
+  typedef PortD Port;
+  static const uint8_t BIT = PD4, MUX = 0b100000, DIDR = 2, DIDR_BIT = 0;
 };
 
-template<> class TAdcPinInput<11> : public AdcPinInput {
-public:
-  typedef TPin<PortB,PB4> PinType;
-
-  TAdcPinInput()
-  : AdcPinInput(0b100011) {
-    DDRB &= ~(_BV(PB4));
-    DIDR2 |= _BV(3);
-  }
+template<> struct TAdcPinTraits<9> {
+  typedef PortD Port;
+  static const uint8_t BIT = PD6, MUX = 0b100001, DIDR = 2, DIDR_BIT = 1;
+};
 
-  virtual ~TAdcPinInput() {}
+template<> struct TAdcPinTraits<10> {
+  typedef PortD Port;
+  static const uint8_t BIT = PD7, MUX = 0b100010, DIDR = 2, DIDR_BIT = 2;
+};
 
-  Pin& pin() { return m_pin; }
+template<> struct TAdcPinTraits<11> {
+  typedef PortB Port;
+  static const uint8_t BIT = PB4, MUX = 0b100011, DIDR = 2, DIDR_BIT = 3;
+};
 
-  /**
-   * Returns singleton instance of this specialization of the TAdcPinInput template.
-   */
-  static TAdcPinInput& instance() {
-    return s_singleton;
-  }
+template<> struct TAdcPinTraits<12> {
+  typedef PortB Port;
+  static const uint8_t BIT = PB5, MUX = 0b100100, DIDR = 2, DIDR_BIT = 4;
+};
 
-protected:
-  PinType m_pin;
-  static TAdcPinInput s_singleton;
+template<> struct TAdcPinTraits<13> {
+  typedef PortB Port;
+  static const uint8_t BIT = PB6, MUX = 0b100101, DIDR = 2, DIDR_BIT = 5;
 };
 
-template<> class TAdcPinInput<12> : public AdcPinInput {
+/**
+ * ADC input pin for one ADC channel, described by TAdcPinTraits.
+ *
+ * Each channel has a single instance, accessed via the static instance()
+ * method. The instance is a static member of the template, so it exists
+ * only for channels the application references: pins that are never
+ * named cost no RAM or flash and keep their digital input buffer. The
+ * instance is constructed during static initialization, which disables
+ * the digital input of its pin and makes it an input.
+ */
+template<int ADC_CHANNEL> class TAdcPinInput : public AdcPinInput {
 public:
-  typedef TPin<PortB,PB5> PinType;
 
-  TAdcPinInput()
-  : AdcPinInput(0b100100) {
-    DDRB &= ~(_BV(PB5));
-    DIDR2 |= _BV(4);
-  }
+  typedef TAdcPinTraits<ADC_CHANNEL> Traits;
+  typedef TPin<typename Traits::Port, Traits::BIT> PinType;
 
   virtual ~TAdcPinInput() {}
 
@@ -285,34 +144,18 @@ public:
   }
 
 protected:
-  PinType m_pin;
-  static TAdcPinInput s_singleton;
-};
-
-template<> class TAdcPinInput<13> : public AdcPinInput {
-public:
-  typedef TPin<PortB,PB6> PinType;
 
   TAdcPinInput()
-  : AdcPinInput(0b100101) {
-    DDRB &= ~(_BV(PB5));
-    DIDR2 |= _BV(5);
+  : AdcPinInput(Traits::MUX) {
+    Traits::Port::ddr() &= ~_BV(Traits::BIT);
+    if (Traits::DIDR == 0) DIDR0 |= _BV(Traits::DIDR_BIT);
+    else DIDR2 |= _BV(Traits::DIDR_BIT);
   }
 
-  virtual ~TAdcPinInput() {}
-
-  Pin& pin() { return m_pin; }
-
-  /**
-   * Returns singleton instance of this specialization of the TAdcPinInput template.
-   */
-  static TAdcPinInput& instance() {
-    return s_singleton;
-  }
-
-protected:
   PinType m_pin;
   static TAdcPinInput s_singleton;
 };
 
+template<int ADC_CHANNEL> TAdcPinInput<ADC_CHANNEL> TAdcPinInput<ADC_CHANNEL>::s_singleton;
+
 #endif /* ADCPININPUT_H_ */
@@ -0,0 +1,106 @@
+/*
+ * TSampleBlockBuffer.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef TSAMPLEBLOCKBUFFER_H_
+#define TSAMPLEBLOCKBUFFER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ProximitySensor.h>
+
+/**
+ * A pair of fixed-size blocks of raw sample pairs used to stream data
+ * from a ProximitySensor. One block is filled while the other is
+ * consumed. Filling may be done in steps to interleave acquisition with
+ * other work, e.g.:
+ *
+ *   TSampleBlockBuffer<64> buffer;
+ *
+ *   void loop() {
+ *     buffer.fill(sensor, 8);
+ *     if (buffer.available()) {
+ *       log(buffer.block(), buffer.size());
+ *       buffer.release();
+ *     }
+ *   }
+ *
+ * If a block completes before the previous one has been released, the
+ * unreleased block is replaced and the overrun count is incremented.
+ */
+template<size_t BLOCK_SIZE> class TSampleBlockBuffer {
+public:
+
+  typedef ProximitySensor::SamplePair SamplePair;
+
+  TSampleBlockBuffer()
+  : m_fillIndex(0)
+  , m_fillCount(0)
+  , m_available(false)
+  , m_overruns(0) {
+  }
+
+  /**
+   * Acquires up to maxPairs sample pairs into the block being filled.
+   * Returns true if the block was completed and is now available
+   * for consumption.
+   */
+  bool fill(ProximitySensor& sensor, size_t maxPairs = BLOCK_SIZE) {
+    size_t count = BLOCK_SIZE - m_fillCount;
+    if (count > maxPairs) count = maxPairs;
+    sensor.acquire(&m_blocks[m_fillIndex][m_fillCount], count);
+    m_fillCount += count;
+    if (m_fillCount < BLOCK_SIZE) return false;
+    if (m_available) m_overruns++;
+    m_fillIndex ^= 1;
+    m_fillCount = 0;
+    m_available = true;
+    return true;
+  }
+
+  /**
+   * Indicates whether a completed block is waiting to be consumed.
+   */
+  bool available() const {
+    return m_available;
+  }
+
+  /**
+   * Returns the most recently completed block.
+   */
+  const SamplePair* block() const {
+    return m_blocks[m_fillIndex ^ 1];
+  }
+
+  /**
+   * Marks the completed block as consumed.
+   */
+  void release() {
+    m_available = false;
+  }
+
+  size_t size() const {
+    return BLOCK_SIZE;
+  }
+
+  /**
+   * Returns the number of completed blocks that were replaced before
+   * being released.
+   */
+  uint16_t getOverruns() const {
+    return m_overruns;
+  }
+
+private:
+
+  SamplePair m_blocks[2][BLOCK_SIZE];
+  uint8_t m_fillIndex;
+  size_t m_fillCount;
+  bool m_available;
+  uint16_t m_overruns;
+
+};
+
+#endif /* TSAMPLEBLOCKBUFFER_H_ */
@@ -0,0 +1,222 @@
+/*
+ * GestureRecognizer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <ProximitySensor.h>
+
+// Built only when the sensors report state changes (see ProximitySensor.h).
+#if PROXIMITY_FEATURE(STATE_CALLBACK)
+
+#include <GestureRecognizer.h>
+
+#ifdef AVR_PROJECT_BUILD
+#include "timer.h"
+#else
+#include <Arduino.h>
+#endif
+
+#define DEFAULT_TAP_MS 250
+#define DEFAULT_DOUBLE_TAP_GAP_MS 250
+#define DEFAULT_LONG_PRESS_MS 800
+#define DEFAULT_SWIPE_STEP_MS 300
+#define DEFAULT_SWIPE_MIN_PADS 3
+
+// Pad::flags
+#define PAD_CONTACT 0x01
+#define PAD_TAP_PENDING 0x02
+#define PAD_LONG_REPORTED 0x04
+#define PAD_SWIPE 0x08
+
+GestureRecognizer::GestureRecognizer(ProximitySensor* const* ppSensors, Pad* pPads, const uint8_t count)
+: m_ppSensors(ppSensors)
+, m_pPads(pPads)
+, m_count(count)
+, m_contactState(ProximitySensor::TOUCH)
+, m_tapMs(DEFAULT_TAP_MS)
+, m_doubleTapGapMs(DEFAULT_DOUBLE_TAP_GAP_MS)
+, m_longPressMs(DEFAULT_LONG_PRESS_MS)
+, m_swipeStepMs(DEFAULT_SWIPE_STEP_MS)
+, m_swipeMinPads(DEFAULT_SWIPE_MIN_PADS)
+, m_swipeFirst(0)
+, m_swipeLast(0)
+, m_swipeLength(0)
+, m_swipeDirection(0)
+, m_swipeTimeMs(0)
+, m_deadlinePending(false)
+, m_deadlineMs(0)
+, m_queueHead(0)
+, m_queueCount(0)
+, m_overruns(0)
+{
+}
+
+void GestureRecognizer::attach() {
+  for (uint8_t i=0; i < m_count; i++) {
+    Pad& pad = m_pPads[i];
+    pad.pOwner = this;
+    pad.contactMs = 0;
+    pad.releaseMs = 0;
+    pad.index = i;
+    pad.flags = 0;
+    m_ppSensors[i]->setOnStateChangeCallback(&GestureRecognizer::onStateChange, &pad);
+  }
+  m_swipeLength = 0;
+  m_deadlinePending = false;
+  m_queueHead = 0;
+  m_queueCount = 0;
+  m_overruns = 0;
+}
+
+void GestureRecognizer::onStateChange(void* data, ProximitySensor::State from, ProximitySensor::State to,
+                                      uint32_t timeMs) {
+  Pad& pad = *(Pad*)data;
+  GestureRecognizer& recognizer = *pad.pOwner;
+  bool wasInContact = from >= recognizer.m_contactState;
+  bool isInContact = to >= recognizer.m_contactState;
+  if (isInContact && !wasInContact) {
+    recognizer.contact(pad, timeMs);
+  }
+  else if (wasInContact && !isInContact && (pad.flags & PAD_CONTACT)) {
+    recognizer.release(pad, timeMs);
+  }
+}
+
+void GestureRecognizer::contact(Pad& pad, const uint32_t timeMs) {
+
+  // A tap whose gap has passed is reported before the next contact.
+  if ((pad.flags & PAD_TAP_PENDING) && timeMs - pad.releaseMs > m_doubleTapGapMs) {
+    pad.flags &= ~PAD_TAP_PENDING;
+    report(TAP, pad.index, pad.index, pad.releaseMs);
+  }
+
+  pad.flags = (pad.flags | PAD_CONTACT) & ~(PAD_LONG_REPORTED | PAD_SWIPE);
+  pad.contactMs = timeMs;
+  schedule(timeMs + m_longPressMs);
+
+  // Extend the swipe in progress if this pad is next to the last one, in
+  // the same direction, soon enough.
+  int16_t step = (int16_t)pad.index - m_swipeLast;
+  if (m_swipeLength && (step == 1 || step == -1) && (m_swipeDirection == 0 || step == m_swipeDirection)
+      && timeMs - m_swipeTimeMs <= m_swipeStepMs) {
+    if (m_swipeLength == 1) {
+      // The first pad may already have been released as a tap.
+      m_pPads[m_swipeFirst].flags = (m_pPads[m_swipeFirst].flags | PAD_SWIPE) & ~PAD_TAP_PENDING;
+    }
+    pad.flags |= PAD_SWIPE;
+    m_swipeDirection = step;
+    m_swipeLength++;
+  }
+  else {
+    m_swipeFirst = pad.index;
+    m_swipeDirection = 0;
+    m_swipeLength = 1;
+  }
+  m_swipeLast = pad.index;
+  m_swipeTimeMs = timeMs;
+}
+
+void GestureRecognizer::release(Pad& pad, const uint32_t timeMs) {
+
+  pad.flags &= ~PAD_CONTACT;
+
+  if (pad.flags & PAD_SWIPE) {
+    if (pad.index == m_swipeLast && m_swipeLength >= m_swipeMinPads) {
+      report(m_swipeDirection > 0 ? SWIPE_FORWARD : SWIPE_BACKWARD, m_swipeFirst, m_swipeLast, timeMs);
+      m_swipeLength = 0;
+    }
+    return;
+  }
+
+  bool tap = !(pad.flags & PAD_LONG_REPORTED) && timeMs - pad.contactMs <= m_tapMs;
+
+  if (pad.flags & PAD_TAP_PENDING) {
+    pad.flags &= ~PAD_TAP_PENDING;
+    if (tap) {
+      report(DOUBLE_TAP, pad.index, pad.index, timeMs);
+      return;
+    }
+    report(TAP, pad.index, pad.index, pad.releaseMs);
+  }
+
+  if (!tap) return;
+
+  pad.flags |= PAD_TAP_PENDING;
+  pad.releaseMs = timeMs;
+  schedule(tapDueMs(pad) + 1);
+}
+
+uint32_t GestureRecognizer::tapDueMs(const Pad& pad) const {
+  // A tap on the only pad of the swipe in progress may still turn out to
+  // be the start of a swipe until the swipe step time has passed.
+  uint32_t dueMs = pad.releaseMs + m_doubleTapGapMs;
+  if (m_swipeLength == 1 && m_swipeLast == pad.index) {
+    uint32_t swipeDueMs = m_swipeTimeMs + m_swipeStepMs;
+    if ((int32_t)(swipeDueMs - dueMs) > 0) dueMs = swipeDueMs;
+  }
+  return dueMs;
+}
+
+void GestureRecognizer::schedule(const uint32_t deadlineMs) {
+  if (!m_deadlinePending || (int32_t)(deadlineMs - m_deadlineMs) < 0) {
+    m_deadlineMs = deadlineMs;
+    m_deadlinePending = true;
+  }
+}
+
+void GestureRecognizer::expire(const uint32_t nowMs) {
+  m_deadlinePending = false;
+  for (uint8_t i=0; i < m_count; i++) {
+    Pad& pad = m_pPads[i];
+    // A pending tap followed by a contact is settled on its release.
+    if ((pad.flags & (PAD_TAP_PENDING | PAD_CONTACT)) == PAD_TAP_PENDING) {
+      uint32_t dueMs = tapDueMs(pad);
+      if ((int32_t)(nowMs - dueMs) > 0) {
+        pad.flags &= ~PAD_TAP_PENDING;
+        report(TAP, i, i, pad.releaseMs);
+      }
+      else {
+        schedule(dueMs + 1);
+      }
+    }
+    if ((pad.flags & (PAD_CONTACT | PAD_LONG_REPORTED | PAD_SWIPE)) == PAD_CONTACT) {
+      if (nowMs - pad.contactMs >= m_longPressMs) {
+        if (pad.flags & PAD_TAP_PENDING) report(TAP, i, i, pad.releaseMs);
+        pad.flags = (pad.flags | PAD_LONG_REPORTED) & ~PAD_TAP_PENDING;
+        report(LONG_PRESS, i, i, pad.contactMs + m_longPressMs);
+      }
+      else {
+        schedule(pad.contactMs + m_longPressMs);
+      }
+    }
+  }
+}
+
+void GestureRecognizer::report(const Type type, const uint8_t pad, const uint8_t lastPad, const uint32_t timeMs) {
+  if (m_queueCount == QUEUE_SIZE) {
+    m_overruns++;
+    return;
+  }
+  Gesture& gesture = m_queue[(m_queueHead + m_queueCount) % QUEUE_SIZE];
+  gesture.type = type;
+  gesture.pad = pad;
+  gesture.lastPad = lastPad;
+  gesture.timeMs = timeMs;
+  m_queueCount++;
+}
+
+bool GestureRecognizer::poll(Gesture& gesture, const uint32_t nowMs) {
+  if (m_deadlinePending && (int32_t)(nowMs - m_deadlineMs) >= 0) expire(nowMs);
+  if (m_queueCount == 0) return false;
+  gesture = m_queue[m_queueHead];
+  m_queueHead = (m_queueHead + 1) % QUEUE_SIZE;
+  m_queueCount--;
+  return true;
+}
+
+bool GestureRecognizer::poll(Gesture& gesture) {
+  return poll(gesture, millis());
+}
+
+#endif
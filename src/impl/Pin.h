@@ -27,23 +27,23 @@ public:
 };
 
 template<typename TPort, int PIN> void TPin<TPort,PIN>::startCharge() {
-  TPort::PORT |= (1 << PIN); // set on or connect pull-up).
-  TPort::DDR |= (1 << PIN);  // select output mode (drive-high)
+  TPort::port() |= (1 << PIN); // set on or connect pull-up).
+  TPort::ddr() |= (1 << PIN);  // select output mode (drive-high)
 }
 
 template<typename TPort, int PIN> void TPin<TPort,PIN>::stopCharge() {
-  TPort::DDR &= ~(1 << PIN);  // select input mode
-  TPort::PORT &= ~(1 << PIN); // disconnect pull-up (tri-state)
+  TPort::ddr() &= ~(1 << PIN);  // select input mode
+  TPort::port() &= ~(1 << PIN); // disconnect pull-up (tri-state)
 }
 
 template<typename TPort, int PIN> void TPin<TPort,PIN>::startDischarge() {
-  TPort::PORT &= ~(1 << PIN); // set off or disconnect pull-up
-  TPort::DDR |= (1 << PIN);   // select output mode (drive-low)
+  TPort::port() &= ~(1 << PIN); // set off or disconnect pull-up
+  TPort::ddr() |= (1 << PIN);   // select output mode (drive-low)
 }
 
 template<typename TPort, int PIN> void TPin<TPort,PIN>::stopDischarge() {
-  TPort::PORT &= ~(1 << PIN); // disconnect pull-up (tri-state)
-  TPort::DDR &= ~(1 << PIN);  // select input mode
+  TPort::port() &= ~(1 << PIN); // disconnect pull-up (tri-state)
+  TPort::ddr() &= ~(1 << PIN);  // select input mode
 }
 
 
@@ -8,7 +8,11 @@
 #include <stdlib.h>
 #include <avr/interrupt.h>
 #include <ProximitySensor.h>
+#include <SampleTimer.h>
 #include <util/delay.h>
+#include <util/delay_basic.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
 
 #ifdef AVR_PROJECT_BUILD
 #include "timer.h"
@@ -27,12 +31,157 @@
 #define DEFAULT_TOUCH_TIMEOUT_MS 10000
 #define DEFAULT_DELAY_MS 20
 #define DEFAULT_RESOLUTION 7
+#define DEFAULT_DISCHARGE_DELAY_US 30
+
+#define MAX_DISCHARGE_DELAY_US 100
+
+// Adaptive jitter: smoothing of the per-pair difference and of the
+// per-bin deviation from it (as right shifts).
+#define JITTER_MEAN_SHIFT 4
+#define JITTER_NOISE_SHIFT 3
+
+// Interference detection: entries in the autocorrelation buffer and the
+// pairs summed into each entry. At the default timing the buffer spans
+// about 53 ms. Lags stop at half the buffer, about 26 ms, so that every
+// correlation averages enough products to stay below the threshold on
+// clean input, which still covers one period of 50 Hz hum.
+#define INTERFERENCE_ENTRIES 96
+#define INTERFERENCE_DECIMATION 2
+#define INTERFERENCE_MAX_LAG (INTERFERENCE_ENTRIES / 2)
+// Standard deviations of the correlation of uncorrelated noise that a
+// peak must exceed.
+#define INTERFERENCE_SIGMAS 4
+
+#define MAINS_PERIOD_US (1000000UL / PROXIMITY_MAINS_HZ)
+
+// Sample pairs acquired per pass of the update<RESOLUTION>() loop.
+// Resolutions with fewer pairs are fully unrolled.
+#define UNROLLED_PAIRS 4
+
+// Discharge delay calibration: a long delay known to leave no residual
+// charge and the number of pairs compared per candidate. A candidate
+// passes when its total difference from the reference is within the
+// given number of standard deviations of the measured noise, or within
+// half a count on average when the readings are quieter than that.
+#define CALIBRATION_REFERENCE_DELAY_US 60
+#define CALIBRATION_PAIRS 32
+#define VERIFICATION_PAIRS 16
+#define CALIBRATION_NOISE_SIGMAS 3
+
+#define DISCHARGE_DELAY_RECORD_MAGIC 0xD5
+
+// Electrode diagnostics. Readings within the margin of either end of the
+// ADC range count as pinned to that end.
+#define HEALTH_PAIRS 4
+#define HEALTH_RAIL_MARGIN 8
+#define DEFAULT_OPEN_THRESHOLD 16
+
+/**
+ * Converts a delay to _delay_loop_2() iterations of four cycles each. The
+ * clock is taken in whole MHz so that clocks below 4 MHz are not rounded
+ * to zero loops, which _delay_loop_2() would run as 65536; at least one
+ * loop is returned.
+ */
+static inline uint16_t usToDelayLoops(const uint8_t us) {
+  uint16_t loops = (uint16_t)us * (F_CPU / 1000000UL) / 4;
+  return loops ? loops : 1;
+}
+
+/**
+ * Candidate S&H discharge delays, in microseconds, in increasing order.
+ */
+static const uint8_t DISCHARGE_DELAY_STEPS[] = { 2, 3, 4, 6, 8, 10, 12, 15, 20, 25, 30, 40, 60 };
+
+// State machine transitions (see TRANSITIONS). The low bits hold the
+// next state; the rest are actions applied in the order listed.
+#define TRANSITION_STATE 0x07
+// Guard: enter the next state once the sample has been in this band for
+// longer than the debounce delay. Starts the delay on first entry.
+#define TRANSITION_DEBOUNCE 0x08
+// Guard: enter the next state once this state has outlasted its timeout.
+#define TRANSITION_TIMEOUT 0x10
+#define TRANSITION_CLEAR_DELAY 0x20
+#define TRANSITION_ADAPT 0x40
+#define TRANSITION_SNAP 0x80
+
+#define STAY_ADAPTING(state) ((state) | TRANSITION_CLEAR_DELAY | TRANSITION_ADAPT)
+#define RESEED_IDLE (ProximitySensor::IDLE | TRANSITION_CLEAR_DELAY | TRANSITION_SNAP)
+#define DEBOUNCE_PROXIMITY (ProximitySensor::PROXIMITY | TRANSITION_DEBOUNCE | TRANSITION_CLEAR_DELAY)
+#define TIMEOUT_IDLE (ProximitySensor::IDLE | TRANSITION_TIMEOUT | TRANSITION_SNAP)
+#define DROP_IDLE (ProximitySensor::IDLE | TRANSITION_ADAPT)
+#define ENTER(state) (state)
+
+/**
+ * Transition taken by update(uint32_t) for each state and sample band.
+ * Columns come in pairs for a band, at or above the release threshold
+ * and then below it. The bands, by sample against the reseed (R),
+ * proximity (P) and touch (T) thresholds computed from the moving
+ * average, are:
+ *
+ *   0  below R
+ *   1  R and above, below P
+ *   2  at P, below T
+ *   3  above P, below T
+ *   4  at P and at T (P == T)
+ *   5  above P, at or above T
+ *
+ * When a transition leads to a later state, that state's entry for the
+ * same column is applied as well, so one sample can go from IDLE through
+ * PROXIMITY to TOUCH.
+ */
+static const uint8_t TRANSITIONS[ProximitySensor::STATE_COUNT][12] PROGMEM = {
+  // IDLE: debounce above P, reseed below R, otherwise adapt.
+  {
+    RESEED_IDLE, RESEED_IDLE,
+    STAY_ADAPTING(ProximitySensor::IDLE), STAY_ADAPTING(ProximitySensor::IDLE),
+    STAY_ADAPTING(ProximitySensor::IDLE), STAY_ADAPTING(ProximitySensor::IDLE),
+    DEBOUNCE_PROXIMITY, DEBOUNCE_PROXIMITY,
+    STAY_ADAPTING(ProximitySensor::IDLE), STAY_ADAPTING(ProximitySensor::IDLE),
+    DEBOUNCE_PROXIMITY, DEBOUNCE_PROXIMITY
+  },
+  // PROXIMITY: touch at T, drop below P, otherwise time out.
+  {
+    DROP_IDLE, DROP_IDLE,
+    DROP_IDLE, DROP_IDLE,
+    TIMEOUT_IDLE, TIMEOUT_IDLE,
+    TIMEOUT_IDLE, TIMEOUT_IDLE,
+    ENTER(ProximitySensor::TOUCH), ENTER(ProximitySensor::TOUCH),
+    ENTER(ProximitySensor::TOUCH), ENTER(ProximitySensor::TOUCH)
+  },
+  // TOUCH: below the release threshold, fall back to PROXIMITY at or
+  // above P or drop below it; otherwise time out.
+  {
+    TIMEOUT_IDLE, DROP_IDLE,
+    TIMEOUT_IDLE, DROP_IDLE,
+    TIMEOUT_IDLE, ENTER(ProximitySensor::PROXIMITY),
+    TIMEOUT_IDLE, ENTER(ProximitySensor::PROXIMITY),
+    TIMEOUT_IDLE, ENTER(ProximitySensor::PROXIMITY),
+    TIMEOUT_IDLE, ENTER(ProximitySensor::PROXIMITY)
+  }
+};
+
+/**
+ * EEPROM record written by saveDischargeDelay().
+ */
+struct DischargeDelayRecord {
+  uint8_t magic;
+  uint8_t profile;
+  uint8_t delayUs;
+  uint8_t check;
+};
 
 /**
  * Function that selects compile-time generated delays required for randomization of capacitive charging cycle.
  */
-static void random_delay() {
-  switch(rand() / (RAND_MAX / 7)) {
+void ProximitySensor::randomDelay() {
+  jitterDelay(rand() % JITTER_BINS);
+}
+
+/**
+ * Waits for the charge delay of the given jitter bin, 16 us + bin.
+ */
+void ProximitySensor::jitterDelay(const uint8_t bin) {
+  switch(bin) {
   case 0:
     _delay_us(16);
     break;
@@ -68,24 +217,69 @@ ProximitySensor::ProximitySensor(AdcPinInput* pReferencePin, AdcPinInput* pSenso
 , m_pSensorPin(pSensorPin)
 , m_resolution(DEFAULT_RESOLUTION)
 , m_filterAdaptationRate(DEFAULT_FILTER_ADAPTATION_RATE)
+#if PROXIMITY_FEATURE(RESEED)
 , m_filterReseedThreshold(DEFAULT_FILTER_RESEED_THRESHOLD)
-, m_idleStartTimeMs(millis())
+#endif
 , m_proximityThreshold(DEFAULT_PROXIMITY_THRESHOLD)
-, m_proximityTimeoutMs(DEFAULT_PROXIMITY_TIMEOUT_MS)
-, m_proximityStartTimeMs(0)
 , m_touchThreshold(DEFAULT_TOUCH_THRESHOLD)
-, m_touchTimeoutMs(DEFAULT_TOUCH_TIMEOUT_MS)
-, m_touchStartTimeMs(0)
 , m_releaseThreshold(DEFAULT_RELEASE_THRESHOLD)
+#if PROXIMITY_FEATURE(DEBOUNCE)
 , m_delayMs(DEFAULT_DELAY_MS)
 , m_delayStartTimeMs(0)
+, m_delaying(false)
+#endif
 , m_movingAverage(0)
 , m_state(IDLE)
 , m_reseed(true)
 , m_reseedSampleCount(0)
+, m_dischargeDelayUs(DEFAULT_DISCHARGE_DELAY_US)
+, m_dischargeDelayLoops(usToDelayLoops(DEFAULT_DISCHARGE_DELAY_US))
+, m_verifyInterval(0)
+, m_updatesSinceVerify(0)
+, m_dischargedInterval(0)
+, m_dischargedAge(0)
+, m_dischargedSeeded(false)
+, m_dischargedReference(0)
+, m_dischargedDeviation(0)
+, m_adaptiveJitter(false)
+, m_jitterBin(0)
+, m_jitterMean(0)
+, m_interferenceHz(0)
+, m_health(HEALTHY)
+, m_healthCheckInterval(0)
+, m_updatesSinceHealthCheck(0)
+, m_openThreshold(DEFAULT_OPEN_THRESHOLD)
+#if PROXIMITY_HUM_FILTER == PROXIMITY_HUM_FILTER_COMB
+, m_combDelay(0)
+, m_combIndex(0)
+, m_combCount(0)
+#endif
+, m_stepTotal(0)
+, m_stepCount(0)
+, m_arrayDifference(0)
+, m_paced(false)
+, m_sampleTick(0)
+, m_missedTicks(0)
+, m_sampleTimeMs(0)
+#if PROXIMITY_FEATURE(SAMPLE_CALLBACK)
 , m_onSampleCallbackData(0)
 , m_onSampleCallback(0)
+#endif
+#if PROXIMITY_FEATURE(STATE_CALLBACK)
+, m_onStateChangeCallbackData(0)
+, m_onStateChangeCallback(0)
+#endif
 {
+#if PROXIMITY_FEATURE(TIMEOUTS) || PROXIMITY_FEATURE(STATISTICS)
+  m_stateStartTimeMs[IDLE] = millis();
+  m_stateStartTimeMs[PROXIMITY] = 0;
+  m_stateStartTimeMs[TOUCH] = 0;
+#endif
+#if PROXIMITY_FEATURE(TIMEOUTS)
+  m_stateTimeoutMs[PROXIMITY - 1] = DEFAULT_PROXIMITY_TIMEOUT_MS;
+  m_stateTimeoutMs[TOUCH - 1] = DEFAULT_TOUCH_TIMEOUT_MS;
+#endif
+  setAdaptiveJitter(false);
 }
 
 void ProximitySensor::begin() {
@@ -98,81 +292,686 @@ void ProximitySensor::begin() {
   ADCSRA |= (1<<ADEN);
 }
 
+inline uint16_t ProximitySensor::acquireDischarged() {
+
+  // Ground Mux and discharge S&H cap
+  ADMUX |= 0b11111;
+
+  // This delay had to be increased after introducing LED animation.
+  // The S&H cap did not appear to be fully discharging before a new sample was taken.
+  // It is now set per sensor; see calibrateDischargeDelay().
+  _delay_loop_2(m_dischargeDelayLoops);
+
+  // Connect reference pin to S&H cap
+  m_pReferencePin->select();
+  // Charge S&H cap
+  m_pReferencePin->pin().startCharge();
+  // Discharge sensor cap
+  m_pSensorPin->pin().startDischarge();
+
+  chargeDelay();
+
+  // Let sensor pin float
+  m_pSensorPin->pin().stopDischarge();
+
+  m_pSensorPin->select();
+
+  return getAdcSample();
+}
+
+inline uint16_t ProximitySensor::acquireCharged() {
+
+  // Connect reference pin to S&H cap
+  m_pReferencePin->select();
+  // Discharge S&H cap
+  m_pReferencePin->pin().startDischarge();
+  // Charge sensor cap
+  m_pSensorPin->pin().startCharge();
+
+  chargeDelay();
+
+  // Let sensor pin float
+  m_pSensorPin->pin().stopCharge();
+
+  // Connect sensor pin to S&H cap
+  m_pSensorPin->select();
+
+  return getAdcSample();
+}
+
+inline void ProximitySensor::acquireDifferentialPair(SamplePair& pair) {
+  cli();
+  pair.discharged = acquireDischarged();
+  pair.charged = acquireCharged();
+  sei();
+}
+
+inline void ProximitySensor::chargeDelay() {
+  if (m_adaptiveJitter) jitterDelay(m_jitterBin);
+  else randomDelay();
+}
+
+inline void ProximitySensor::selectJitterBin() {
+  // Of two random bins, use the quieter one. Every bin remains
+  // reachable, so its statistics keep being refreshed, but quiet
+  // timings are chosen far more often than noisy ones.
+  uint8_t choices = rand();
+  uint8_t first = choices & (JITTER_BINS - 1);
+  uint8_t second = (choices >> 3) & (JITTER_BINS - 1);
+  m_jitterBin = m_jitterNoise[first] <= m_jitterNoise[second] ? first : second;
+}
+
+void ProximitySensor::recordJitterNoise(const int16_t difference) {
+  // Deviation of this pair from the recent mean, in 1/16 counts.
+  int16_t error = (difference << 4) - m_jitterMean;
+  m_jitterMean += error >> JITTER_MEAN_SHIFT;
+  int16_t magnitude = error < 0 ? -error : error;
+  int16_t noise = m_jitterNoise[m_jitterBin];
+  m_jitterNoise[m_jitterBin] = noise + ((magnitude - noise) >> JITTER_NOISE_SHIFT);
+}
+
+inline void ProximitySensor::acquirePair(SamplePair& pair) {
+
+  if (m_adaptiveJitter) selectJitterBin();
+
+  if (m_dischargedInterval <= 1) acquireDifferentialPair(pair);
+  else acquireSingleEndedPair(pair);
+
+  if (m_adaptiveJitter) recordJitterNoise(pair.charged - pair.discharged);
+}
+
+inline void ProximitySensor::acquireSingleEndedPair(SamplePair& pair) {
+
+  if (m_dischargedAge == 0) {
+    acquireDifferentialPair(pair);
+    if (m_dischargedSeeded) {
+      // Track how far the reference moved while it was being reused,
+      // in 1/16 counts with a 1/8 smoothing factor.
+      int16_t change = (int16_t)(pair.discharged - m_dischargedReference);
+      uint16_t magnitude = (change < 0 ? -change : change) << 4;
+      m_dischargedDeviation += ((int16_t)magnitude - (int16_t)m_dischargedDeviation) >> 3;
+    }
+    m_dischargedReference = pair.discharged;
+    m_dischargedSeeded = true;
+  }
+  else {
+    cli();
+    pair.charged = acquireCharged();
+    sei();
+    pair.discharged = m_dischargedReference;
+  }
+
+  if (++m_dischargedAge >= m_dischargedInterval) m_dischargedAge = 0;
+}
+
+inline void ProximitySensor::verifyIfDue() {
+  if (m_verifyInterval && ++m_updatesSinceVerify >= m_verifyInterval) {
+    m_updatesSinceVerify = 0;
+    verifyDischargeDelay();
+  }
+}
+
+inline bool ProximitySensor::checkHealthIfDue() {
+  if (m_healthCheckInterval && ++m_updatesSinceHealthCheck >= m_healthCheckInterval) {
+    m_updatesSinceHealthCheck = 0;
+    diagnose();
+  }
+  return m_health == HEALTHY;
+}
+
+/**
+ * Runs the scheduled checks that precede every acquisition, whichever
+ * update method performs it. Returns false while the electrode is not
+ * HEALTHY, in which case the acquisition is skipped.
+ */
+bool ProximitySensor::prepareUpdate() {
+  if (!checkHealthIfDue()) return false;
+  verifyIfDue();
+  return true;
+}
+
+inline int16_t ProximitySensor::acquireDifference() {
+
+  SamplePair pair;
+  acquirePair(pair);
+
+#if PROXIMITY_FEATURE(SAMPLE_CALLBACK)
+  if (m_onSampleCallback) (*m_onSampleCallback)(m_onSampleCallbackData);
+#endif
+
+  return pair.charged-pair.discharged;
+}
+
+/**
+ * Selects the accumulator for update<RESOLUTION>(). A 16-bit total holds
+ * up to 64 differences of a 10-bit ADC.
+ */
+template<bool NARROW> struct TAccumulator {
+  typedef uint32_t type;
+};
+
+template<> struct TAccumulator<true> {
+  typedef uint16_t type;
+};
+
+uint32_t ProximitySensor::filterHum(uint32_t sample) {
+
+#if PROXIMITY_HUM_FILTER == PROXIMITY_HUM_FILTER_COMB
+  // Two-tap comb over the paced sample stream: y[n] = (x[n] + x[n-D]) / 2
+  // with D samples spanning half a mains period.
+  if (m_combDelay) {
+    uint32_t delayed = m_combHistory[m_combIndex];
+    m_combHistory[m_combIndex] = sample;
+    if (++m_combIndex >= m_combDelay) m_combIndex = 0;
+    if (m_combCount < m_combDelay) m_combCount++;
+    else sample = (sample + delayed) >> 1;
+  }
+#endif
+
+  return sample;
+}
+
+template<uint8_t RESOLUTION> uint32_t ProximitySensor::update() {
+
+  static const uint16_t SAMPLE_COUNT = 1U << RESOLUTION;
+
+  if (!prepareUpdate()) return 0;
+
+#if PROXIMITY_HUM_FILTER == PROXIMITY_HUM_FILTER_SYNC
+
+  // Acquire at least SAMPLE_COUNT pairs, then extend the window to the
+  // next whole number of mains periods. Pairs are added while doing so
+  // brings the window closer to the target.
+  uint32_t startUs = micros();
+  uint32_t total = 0;
+  uint16_t count = 0;
+
+  do {
+    total += acquireDifference();
+  } while (++count < SAMPLE_COUNT);
+
+  uint32_t windowUs = micros() - startUs;
+  uint32_t targetUs = (windowUs + MAINS_PERIOD_US - 1) / MAINS_PERIOD_US * MAINS_PERIOD_US;
+
+  while (windowUs + windowUs / count / 2 < targetUs) {
+    total += acquireDifference();
+    count++;
+    windowUs = micros() - startUs;
+  }
+
+  return update(filterHum((total << 8) / count)) >> 8;
+
+#else
+
+  typedef typename TAccumulator<(1023UL << RESOLUTION) <= 0xFFFF>::type Total;
+
+  static const uint16_t UNROLL = SAMPLE_COUNT < UNROLLED_PAIRS ? SAMPLE_COUNT : UNROLLED_PAIRS;
+
+  Total total = 0;
+
+  for (uint16_t i=0; i < SAMPLE_COUNT / UNROLL; i++) {
+    total += acquireDifference();
+    if (UNROLL > 1) total += acquireDifference();
+    if (UNROLL > 2) {
+      total += acquireDifference();
+      total += acquireDifference();
+    }
+  }
+
+  return update(filterHum((uint32_t)(total >> RESOLUTION) << 8)) >> 8;
+
+#endif
+}
+
+template uint32_t ProximitySensor::update<0>();
+template uint32_t ProximitySensor::update<1>();
+template uint32_t ProximitySensor::update<2>();
+template uint32_t ProximitySensor::update<3>();
+template uint32_t ProximitySensor::update<4>();
+template uint32_t ProximitySensor::update<5>();
+template uint32_t ProximitySensor::update<6>();
+template uint32_t ProximitySensor::update<7>();
+template uint32_t ProximitySensor::update<8>();
+template uint32_t ProximitySensor::update<9>();
+template uint32_t ProximitySensor::update<10>();
+
+template<uint8_t RESOLUTION> uint32_t ProximitySensor::updateWithResolution(ProximitySensor& sensor) {
+  return sensor.update<RESOLUTION>();
+}
+
+/**
+ * update<RESOLUTION>() instances indexed by resolution. Kept in flash.
+ */
+const ProximitySensor::UpdateFunction ProximitySensor::s_updateTable[] PROGMEM = {
+  &ProximitySensor::updateWithResolution<0>,
+  &ProximitySensor::updateWithResolution<1>,
+  &ProximitySensor::updateWithResolution<2>,
+  &ProximitySensor::updateWithResolution<3>,
+  &ProximitySensor::updateWithResolution<4>,
+  &ProximitySensor::updateWithResolution<5>,
+  &ProximitySensor::updateWithResolution<6>,
+  &ProximitySensor::updateWithResolution<7>,
+  &ProximitySensor::updateWithResolution<8>,
+  &ProximitySensor::updateWithResolution<9>,
+  &ProximitySensor::updateWithResolution<10>
+};
+
 uint32_t ProximitySensor::update() {
+  UpdateFunction function = (UpdateFunction)pgm_read_ptr(&s_updateTable[m_resolution]);
+  return (*function)(*this);
+}
+
+bool ProximitySensor::updateStep(uint32_t& sample, const uint16_t maxPairs) {
+
+  if (m_stepCount == 0 && maxPairs && !prepareUpdate()) {
+    sample = 0;
+    return true;
+  }
+
+  uint16_t sampleCount = _BV(m_resolution);
+
+  for (uint16_t i=0; i < maxPairs && m_stepCount < sampleCount; i++) {
+    SamplePair pair;
+    acquirePair(pair);
+    m_stepTotal += (pair.charged-pair.discharged);
+    m_stepCount++;
+  }
+
+  if (m_stepCount < sampleCount) return false;
+
+  sample = completeStep();
+  return true;
+}
+
+bool ProximitySensor::updateForUs(uint32_t& sample, const uint32_t budgetUs) {
+
+  if (m_stepCount == 0 && !prepareUpdate()) {
+    sample = 0;
+    return true;
+  }
+
+  uint16_t sampleCount = _BV(m_resolution);
+
+  uint32_t startUs = micros();
+  uint32_t elapsedUs = 0;
+  uint16_t pairs = 0;
+
+  do {
+    SamplePair pair;
+    acquirePair(pair);
+    m_stepTotal += (pair.charged-pair.discharged);
+    m_stepCount++;
+    pairs++;
+    elapsedUs = micros() - startUs;
+  } while (m_stepCount < sampleCount && elapsedUs + elapsedUs / pairs <= budgetUs);
+
+  if (m_stepCount < sampleCount) return false;
+
+  sample = completeStep();
+  return true;
+}
+
+uint32_t ProximitySensor::completeStep() {
+  uint32_t total = m_stepTotal;
+  m_stepTotal = 0;
+  m_stepCount = 0;
+  return update(filterHum((total >> m_resolution) << 8)) >> 8;
+}
 
-  size_t sampleCount = _BV(m_resolution);
+uint32_t ProximitySensor::update(const SamplePair* pPairs, size_t count) {
 
   uint32_t total = 0;
 
-  for (size_t i=0; i < sampleCount; i++) {
+  for (size_t i=0; i < count; i++) {
+    total += (pPairs[i].charged-pPairs[i].discharged);
+  }
 
-    cli();
+  return update((total / count) << 8) >> 8;
+}
 
-    // Ground Mux and discharge S&H cap
-    ADMUX |= 0b11111;
+void ProximitySensor::acquire(SamplePair* pBuffer, size_t count) {
+  for (SamplePair* pEnd = pBuffer + count; pBuffer != pEnd; pBuffer++) {
+    acquirePair(*pBuffer);
+  }
+}
 
-    // This delay had to be increased after introducing LED animation.
-    // The S&H cap did not appear to be fully discharging before a new sample was taken.
-    _delay_us(30);
+void ProximitySensor::acquireSums(uint32_t* pBuffer, size_t count, uint8_t blockBits) {
+  size_t blockSize = _BV(blockBits);
+  for (uint32_t* pEnd = pBuffer + count; pBuffer != pEnd; pBuffer++) {
+    uint32_t total = 0;
+    for (size_t i=0; i < blockSize; i++) {
+      SamplePair pair;
+      acquirePair(pair);
+      total += (pair.charged-pair.discharged);
+    }
+    *pBuffer = total;
+  }
+}
 
-    // Connect reference pin to S&H cap
-    m_pReferencePin->select();
-    // Charge S&H cap
-    m_pReferencePin->pin().startCharge();
-    // Discharge sensor cap
-    m_pSensorPin->pin().startDischarge();
+bool ProximitySensor::updatePaced(uint32_t& sample) {
 
-    random_delay();
+  uint32_t tick = SampleTimer::getTick();
 
-    // Let sensor pin float
-    m_pSensorPin->pin().stopDischarge();
+  if (m_paced && tick == m_sampleTick) {
+    return false;
+  }
 
-    m_pSensorPin->select();
+  if (m_paced) {
+    m_missedTicks += tick - m_sampleTick - 1;
+  }
 
-    uint16_t discharged = getAdcSample();
+  m_sampleTick = tick;
+  m_sampleTimeMs = SampleTimer::ticksToMs(tick);
 
-    // Connect reference pin to S&H cap
-    m_pReferencePin->select();
-    // Discharge S&H cap
-    m_pReferencePin->pin().startDischarge();
-    // Charge sensor cap
-    m_pSensorPin->pin().startCharge();
+  if (!m_paced) {
+    // Switch the state machine time base over to timer ticks.
+    m_paced = true;
+#if PROXIMITY_FEATURE(TIMEOUTS) || PROXIMITY_FEATURE(STATISTICS)
+    for (uint8_t state = 0; state < STATE_COUNT; state++) m_stateStartTimeMs[state] = m_sampleTimeMs;
+#endif
+#if PROXIMITY_FEATURE(DEBOUNCE)
+    m_delaying = false;
+#endif
+#if PROXIMITY_HUM_FILTER == PROXIMITY_HUM_FILTER_COMB
+    uint16_t delay = (SampleTimer::getRateHz() + PROXIMITY_MAINS_HZ) / (2 * PROXIMITY_MAINS_HZ);
+    m_combDelay = delay <= PROXIMITY_HUM_COMB_MAX_DELAY ? delay : 0;
+    m_combIndex = 0;
+    m_combCount = 0;
+#endif
+  }
 
-    random_delay();
+  sample = update();
+  return true;
+}
 
-    // Let sensor pin float
-    m_pSensorPin->pin().stopCharge();
+uint32_t ProximitySensor::currentTimeMs() const {
+  return m_paced ? m_sampleTimeMs : millis();
+}
 
-    // Connect sensor pin to S&H cap
-    m_pSensorPin->select();
+uint8_t ProximitySensor::setDischargeDelayUs(const uint8_t microseconds) {
+  m_dischargeDelayUs = microseconds < 1 ? 1 : microseconds > MAX_DISCHARGE_DELAY_US ? MAX_DISCHARGE_DELAY_US : microseconds;
+  m_dischargeDelayLoops = usToDelayLoops(m_dischargeDelayUs);
+  return m_dischargeDelayUs;
+}
 
-    uint16_t charged = getAdcSample();
+/**
+ * Integer square root, rounded down.
+ */
+static uint16_t squareRoot(uint32_t value) {
+  uint16_t root = 0;
+  for (uint16_t bit = 0x8000; bit; bit >>= 1) {
+    uint16_t trial = root | bit;
+    if ((uint32_t)trial * trial <= value) root = trial;
+  }
+  return root;
+}
 
-    sei();
+/**
+ * Compares (charged - discharged) over pairs taken with the given
+ * discharge delay against interleaved pairs taken with the reference
+ * delay. Interleaving cancels slow drift in the signal. Returns true if
+ * the total difference is within the noise of the per-pair differences,
+ * k * sigma * sqrt(pairs), so that a delay is only rejected for a bias
+ * the measurement can actually resolve.
+ */
+bool ProximitySensor::isDischargeUnbiased(const uint16_t loops, const uint8_t pairs) {
+  uint16_t savedLoops = m_dischargeDelayLoops;
+  int32_t bias = 0;
+  uint32_t squares = 0;
+  for (uint8_t i=0; i < pairs; i++) {
+    SamplePair pair;
+    m_dischargeDelayLoops = loops;
+    acquireDifferentialPair(pair);
+    int16_t difference = (int16_t)(pair.charged-pair.discharged);
+    m_dischargeDelayLoops = usToDelayLoops(CALIBRATION_REFERENCE_DELAY_US);
+    acquireDifferentialPair(pair);
+    difference -= (int16_t)(pair.charged-pair.discharged);
+    bias += difference;
+    squares += (int32_t)difference * difference;
+  }
+  m_dischargeDelayLoops = savedLoops;
+
+  // Sum of squared deviations from the mean difference; the variance of
+  // the total is pairs / (pairs - 1) times this.
+  uint32_t magnitude = bias < 0 ? -bias : bias;
+  uint32_t spread = squares - (magnitude * magnitude) / pairs;
+  uint32_t limit = (uint32_t)CALIBRATION_NOISE_SIGMAS * squareRoot(spread / (pairs - 1) * pairs);
+  if (limit < pairs / 2) limit = pairs / 2;
+  return magnitude <= limit;
+}
+
+uint8_t ProximitySensor::calibrateDischargeDelay() {
+  const uint8_t steps = sizeof(DISCHARGE_DELAY_STEPS);
+  bool previousPassed = false;
+  for (uint8_t i=0; i < steps; i++) {
+    bool passed = isDischargeUnbiased(usToDelayLoops(DISCHARGE_DELAY_STEPS[i]), CALIBRATION_PAIRS);
+    // Require two consecutive passing steps so that a single lucky
+    // measurement does not select a delay that is too short.
+    if (passed && previousPassed) {
+      return setDischargeDelayUs(DISCHARGE_DELAY_STEPS[i - 1]);
+    }
+    previousPassed = passed;
+  }
+  return setDischargeDelayUs(CALIBRATION_REFERENCE_DELAY_US);
+}
+
+bool ProximitySensor::verifyDischargeDelay() {
+  if (isDischargeUnbiased(m_dischargeDelayLoops, VERIFICATION_PAIRS)) {
+    // The current delay passed; step down if the next shorter step passes
+    // too, the same two consecutive passes calibration asks for.
+    for (uint8_t i=sizeof(DISCHARGE_DELAY_STEPS); i-- > 0;) {
+      if (DISCHARGE_DELAY_STEPS[i] < m_dischargeDelayUs) {
+        if (isDischargeUnbiased(usToDelayLoops(DISCHARGE_DELAY_STEPS[i]), VERIFICATION_PAIRS)) {
+          setDischargeDelayUs(DISCHARGE_DELAY_STEPS[i]);
+        }
+        break;
+      }
+    }
+    return true;
+  }
+  for (uint8_t i=0; i < sizeof(DISCHARGE_DELAY_STEPS); i++) {
+    if (DISCHARGE_DELAY_STEPS[i] > m_dischargeDelayUs) {
+      setDischargeDelayUs(DISCHARGE_DELAY_STEPS[i]);
+      return false;
+    }
+  }
+  setDischargeDelayUs(CALIBRATION_REFERENCE_DELAY_US);
+  return false;
+}
+
+ProximitySensor::Health ProximitySensor::diagnose() {
+
+  // Differential pairs so that the discharged half is always measured.
+  uint8_t low = 0;
+  uint8_t high = 0;
+  int16_t total = 0;
+
+  for (uint8_t i=0; i < HEALTH_PAIRS; i++) {
+    SamplePair pair;
+    acquireDifferentialPair(pair);
+    low += (pair.discharged <= HEALTH_RAIL_MARGIN) + (pair.charged <= HEALTH_RAIL_MARGIN);
+    high += (pair.discharged >= 1023 - HEALTH_RAIL_MARGIN) + (pair.charged >= 1023 - HEALTH_RAIL_MARGIN);
+    total += (int16_t)(pair.charged-pair.discharged);
+  }
+
+  Health health = HEALTHY;
+  if (low == 2 * HEALTH_PAIRS) health = SHORT_GROUND;
+  else if (high == 2 * HEALTH_PAIRS) health = SHORT_RAIL;
+  else if (low || high) health = SATURATED;
+  else if (total < (int16_t)(m_openThreshold * HEALTH_PAIRS)) health = OPEN;
+
+  if (health != HEALTHY && m_health == HEALTHY) {
+    // Release directly rather than through the filter, so the average
+    // seen up to the fault is left as is until the reseed discards it.
+#if PROXIMITY_FEATURE(DEBOUNCE)
+    m_delaying = false;
+#endif
+    if (m_state != IDLE) {
+#if PROXIMITY_FEATURE(STATE_CALLBACK)
+      State state = m_state;
+#endif
+#if PROXIMITY_FEATURE(TIMEOUTS) || PROXIMITY_FEATURE(STATISTICS)
+      m_stateStartTimeMs[IDLE] = currentTimeMs();
+#endif
+      m_state = IDLE;
+#if PROXIMITY_FEATURE(STATE_CALLBACK)
+      if (m_onStateChangeCallback) {
+        (*m_onStateChangeCallback)(m_onStateChangeCallbackData, state, IDLE, currentTimeMs());
+      }
+#endif
+    }
+    m_reseed = true;
+  }
+
+  return m_health = health;
+}
+
+uint8_t ProximitySensor::setDischargedReferenceInterval(const uint8_t pairs) {
+  m_dischargedAge = 0;
+  m_dischargedSeeded = false;
+  m_dischargedDeviation = 0;
+  return m_dischargedInterval = pairs;
+}
+
+bool ProximitySensor::setAdaptiveJitter(const bool enable) {
+  for (uint8_t i=0; i < JITTER_BINS; i++) {
+    m_jitterNoise[i] = 0;
+  }
+  m_jitterMean = 0;
+  return m_adaptiveJitter = enable;
+}
+
+uint8_t ProximitySensor::getQuietestJitterDelayUs() const {
+  uint8_t quietest = 0;
+  for (uint8_t i=1; i < JITTER_BINS; i++) {
+    if (m_jitterNoise[i] < m_jitterNoise[quietest]) quietest = i;
+  }
+  return JITTER_MIN_DELAY_US + quietest;
+}
+
+/**
+ * Sum of the products of the entries with the entries lag places later.
+ * The sum is not divided by the number of products, so that long lags,
+ * which sum fewer products, do not amplify noise.
+ */
+static int32_t autocorrelation(const int16_t* pEntries, const uint8_t lag) {
+  int32_t total = 0;
+  for (uint8_t i=0; i + lag < INTERFERENCE_ENTRIES; i++) {
+    total += (int32_t)pEntries[i] * pEntries[i + lag];
+  }
+  return total;
+}
+
+uint16_t ProximitySensor::detectInterference() {
+
+  int16_t entries[INTERFERENCE_ENTRIES];
+  int32_t sum = 0;
 
-    total += (charged-discharged);
+  uint32_t startUs = micros();
 
-    if (m_onSampleCallback) (*m_onSampleCallback)(m_onSampleCallbackData);
+  for (uint8_t i=0; i < INTERFERENCE_ENTRIES; i++) {
+    int16_t entry = 0;
+    for (uint8_t j=0; j < INTERFERENCE_DECIMATION; j++) {
+      SamplePair pair;
+      acquirePair(pair);
+      entry += pair.charged - pair.discharged;
+    }
+    entries[i] = entry;
+    sum += entry;
   }
 
-  return update((total / sampleCount) << 8) >> 8;
+  uint32_t entryUs = (micros() - startUs) / INTERFERENCE_ENTRIES;
+
+  int16_t mean = sum / INTERFERENCE_ENTRIES;
+  for (uint8_t i=0; i < INTERFERENCE_ENTRIES; i++) {
+    entries[i] -= mean;
+  }
+
+  // The dominant period is the lag of the first autocorrelation peak,
+  // after the correlation has turned negative, that comes close to the
+  // highest one. Later peaks at multiples of the period are ignored.
+  int32_t energy = autocorrelation(entries, 0);
+
+  bool crossed = false;
+  int32_t peak = 0;
+  for (uint8_t lag=1; lag < INTERFERENCE_MAX_LAG; lag++) {
+    int32_t correlation = autocorrelation(entries, lag);
+    if (correlation < 0) crossed = true;
+    else if (crossed && correlation > peak) peak = correlation;
+  }
+
+  crossed = false;
+  uint8_t peakLag = 0;
+  int32_t previous = 0;
+  for (uint8_t lag=1; lag < INTERFERENCE_MAX_LAG && !peakLag; lag++) {
+    int32_t correlation = autocorrelation(entries, lag);
+    if (correlation < 0) crossed = true;
+    else if (crossed && correlation < previous && previous >= peak - peak / 4) peakLag = lag - 1;
+    previous = correlation;
+  }
+
+  if (peakLag == 0 || entryUs == 0) {
+    return m_interferenceHz = 0;
+  }
+
+  // Require the peak to carry at least a quarter of the signal energy and
+  // to stand clear of the correlation that noise alone produces at its
+  // lag, whose standard deviation is about energy * sqrt(entries - lag) /
+  // entries. The divisor is eight times entries / sqrt(entries - lag).
+  uint16_t noiseDivisor = squareRoot((uint32_t)INTERFERENCE_ENTRIES * INTERFERENCE_ENTRIES * 64
+                                     / (INTERFERENCE_ENTRIES - peakLag));
+  if (peak < energy / 4 || peak < (int64_t)energy * 8 * INTERFERENCE_SIGMAS / noiseDivisor) {
+    return m_interferenceHz = 0;
+  }
+
+  return m_interferenceHz = (1000000UL + peakLag * entryUs / 2) / (peakLag * entryUs);
+}
+
+uint8_t ProximitySensor::getAdcProfile() {
+  // Reference selection, prescaler and high-speed mode.
+  return (ADMUX & (_BV(REFS1) | _BV(REFS0)))
+         | (ADCSRB & _BV(ADHSM) ? 0x08 : 0)
+         | (ADCSRA & (_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0)));
+}
+
+void ProximitySensor::saveDischargeDelay(const uint16_t eepromAddress) const {
+  DischargeDelayRecord record;
+  record.magic = DISCHARGE_DELAY_RECORD_MAGIC;
+  record.profile = getAdcProfile();
+  record.delayUs = m_dischargeDelayUs;
+  record.check = ~m_dischargeDelayUs;
+  eeprom_update_block(&record, (void*)(uintptr_t)eepromAddress, sizeof(record));
+}
+
+bool ProximitySensor::loadDischargeDelay(const uint16_t eepromAddress) {
+  DischargeDelayRecord record;
+  eeprom_read_block(&record, (const void*)(uintptr_t)eepromAddress, sizeof(record));
+  if (record.magic != DISCHARGE_DELAY_RECORD_MAGIC
+      || (uint8_t)~record.check != record.delayUs
+      || record.profile != getAdcProfile()) {
+    return false;
+  }
+  setDischargeDelayUs(record.delayUs);
+  return true;
 }
 
 uint32_t ProximitySensor::updateMovingAverage(uint32_t sample) {
   return m_movingAverage = (int32_t)m_movingAverage + (((int32_t)m_filterAdaptationRate*((int32_t)sample - (int32_t)m_movingAverage)) >> 8);
 }
 
+#if PROXIMITY_FEATURE(STATISTICS)
 uint32_t ProximitySensor::getIdleDurationMs() const {
-  return m_state == TOUCH || m_state == PROXIMITY ? 0 : millis() - m_idleStartTimeMs;
+  return m_state == TOUCH || m_state == PROXIMITY ? 0 : currentTimeMs() - m_stateStartTimeMs[IDLE];
 }
 
 uint32_t ProximitySensor::getProximityDurationMs() const {
-  return m_state == TOUCH || m_state == PROXIMITY ? millis() - m_proximityStartTimeMs : 0;
+  return m_state == TOUCH || m_state == PROXIMITY ? currentTimeMs() - m_stateStartTimeMs[PROXIMITY] : 0;
 }
 
 uint32_t ProximitySensor::getTouchDurationMs() const {
-  return m_state == TOUCH ? millis() - m_touchStartTimeMs : 0;
+  return m_state == TOUCH ? currentTimeMs() - m_stateStartTimeMs[TOUCH] : 0;
 }
+#endif
 
 uint32_t ProximitySensor::update(uint32_t sample) {
 
@@ -182,66 +981,75 @@ uint32_t ProximitySensor::update(uint32_t sample) {
     return sample;
   }
 
+#if PROXIMITY_FEATURE(RESEED)
   uint32_t reseedThreshold = m_movingAverage - ((m_filterReseedThreshold * m_movingAverage) >> 8);
+#else
+  // Every sample is at or above R, so band 0 is never used.
+  const uint32_t reseedThreshold = 0;
+#endif
   uint32_t proximityThreshold = m_movingAverage + ((m_proximityThreshold * m_movingAverage) >> 8);
   uint32_t touchThreshold = proximityThreshold + ((m_touchThreshold * m_movingAverage) >> 8);
   uint32_t releaseThreshold = touchThreshold - ((m_releaseThreshold * m_movingAverage) >> 8);
 
-  if (m_state == IDLE) {
-    if (sample > proximityThreshold) {
-      if (m_delayStartTimeMs == 0) {
-        m_delayStartTimeMs = millis();
-      }
-      else if (millis() - m_delayStartTimeMs > m_delayMs) {
-        m_state = PROXIMITY;
-        m_delayStartTimeMs = 0;
-        m_proximityStartTimeMs = millis();
+  // Band of the sample (see TRANSITIONS). The reseed, proximity and
+  // touch thresholds are in increasing order; the release threshold may
+  // fall anywhere below the touch threshold and is kept as a separate bit.
+  uint8_t band = (sample >= reseedThreshold) + (sample >= proximityThreshold) + (sample > proximityThreshold)
+                 + ((sample >= touchThreshold) << 1);
+  uint8_t column = (band << 1) | (sample < releaseThreshold);
+
+#if PROXIMITY_FEATURES & (PROXIMITY_FEATURE_TIMEOUTS | PROXIMITY_FEATURE_DEBOUNCE | PROXIMITY_FEATURE_STATISTICS \
+                          | PROXIMITY_FEATURE_STATE_CALLBACK)
+  uint32_t now = currentTimeMs();
+#endif
+  uint8_t state = m_state;
+
+  // A transition to a later state evaluates that state with the same
+  // sample and thresholds.
+  for (;;) {
+
+    uint8_t transition = pgm_read_byte(&TRANSITIONS[state][column]);
+    uint8_t next = transition & TRANSITION_STATE;
+
+    // Without debounce the guard always passes; without timeouts the
+    // state never times out.
+    if (transition & TRANSITION_DEBOUNCE) {
+#if PROXIMITY_FEATURE(DEBOUNCE)
+      if (!m_delaying) {
+        m_delayStartTimeMs = now;
+        m_delaying = true;
+        break;
       }
+      if (now - m_delayStartTimeMs <= m_delayMs) break;
+#endif
     }
-    else if (sample < reseedThreshold) {
-      m_delayStartTimeMs = 0;
-      m_movingAverage = sample;
-    }
-    else {
-      m_delayStartTimeMs = 0;
-      updateMovingAverage(sample);
+    else if (transition & TRANSITION_TIMEOUT) {
+#if PROXIMITY_FEATURE(TIMEOUTS)
+      uint32_t timeoutMs = m_stateTimeoutMs[state - 1];
+      if (timeoutMs == 0 || now - m_stateStartTimeMs[state] <= timeoutMs) break;
+#else
+      break;
+#endif
     }
-  }
 
-  if (m_state == PROXIMITY) {
-    if (sample >= touchThreshold) {
-      m_state = TOUCH;
-      m_touchStartTimeMs = millis();
-    }
-    else if (sample < proximityThreshold) {
-      m_state = IDLE;
-      m_idleStartTimeMs = millis();
-      updateMovingAverage(sample);
-    }
-    else if ((m_proximityTimeoutMs > 0 && millis() - m_proximityStartTimeMs) > m_proximityTimeoutMs) {
-      m_state = IDLE;
-      m_idleStartTimeMs = millis();
-      m_movingAverage = sample;
-    }
-  }
+#if PROXIMITY_FEATURE(DEBOUNCE)
+    if (transition & TRANSITION_CLEAR_DELAY) m_delaying = false;
+#endif
+    if (transition & TRANSITION_ADAPT) updateMovingAverage(sample);
+    if (transition & TRANSITION_SNAP) m_movingAverage = sample;
 
-  if (m_state == TOUCH) {
-    if (sample < releaseThreshold) {
-      if (sample >= proximityThreshold) {
-        m_state = PROXIMITY;
-        m_proximityStartTimeMs = millis();
-      }
-      else {
-        m_state = IDLE;
-        m_idleStartTimeMs = millis();
-        updateMovingAverage(sample);
-      }
-    }
-    else if (m_touchTimeoutMs > 0 && millis() - m_touchStartTimeMs > m_touchTimeoutMs) {
-      m_state = IDLE;
-      m_idleStartTimeMs = millis();
-      m_movingAverage = sample;
+    if (next == state) break;
+#if PROXIMITY_FEATURE(TIMEOUTS) || PROXIMITY_FEATURE(STATISTICS)
+    m_stateStartTimeMs[next] = now;
+#endif
+    m_state = (State)next;
+#if PROXIMITY_FEATURE(STATE_CALLBACK)
+    if (m_onStateChangeCallback) {
+      (*m_onStateChangeCallback)(m_onStateChangeCallbackData, (State)state, (State)next, now);
     }
+#endif
+    if (next < state) break;
+    state = next;
   }
 
   return sample;
@@ -0,0 +1,188 @@
+/*
+ * ProximitySensorArray.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <stdlib.h>
+#include <ProximitySensorArray.h>
+#include <avr/interrupt.h>
+#include <util/delay.h>
+#include <util/delay_basic.h>
+
+#define DEFAULT_RESOLUTION 7
+
+// Time allowed for the S&H cap to charge or discharge through the
+// reference pin before it is connected to an electrode. The electrodes
+// themselves settle in the shared window, so only the S&H cap (about
+// 14 pF behind the pin and mux resistance) has to follow, which takes
+// well under a microsecond.
+#define SH_TRANSFER_DELAY_US 4
+
+ProximitySensorArray::ProximitySensorArray(ProximitySensor* const* ppSensors, const uint8_t count)
+: m_ppSensors(ppSensors)
+, m_count(count)
+, m_resolution(DEFAULT_RESOLUTION)
+{
+}
+
+uint8_t ProximitySensorArray::setResolution(const uint8_t resolution) {
+  for (uint8_t i=0; i < m_count; i++) {
+    m_ppSensors[i]->reseed();
+  }
+  return m_resolution = resolution > 10 ? 10 : resolution;
+}
+
+/**
+ * Picks the timing of the shared settle windows. Sensors using adaptive
+ * jitter choose, as ProximitySensor::selectJitterBin() does, the quieter
+ * of two random bins, here by their total noise, and all record their
+ * noise against it. Returns JITTER_BINS, for a random timing, when no
+ * sensor uses adaptive jitter.
+ */
+uint8_t ProximitySensorArray::selectJitterBin() {
+
+  bool adaptive = false;
+  for (uint8_t i=0; i < m_count; i++) {
+    adaptive |= m_ppSensors[i]->m_adaptiveJitter;
+  }
+  if (!adaptive) return ProximitySensor::JITTER_BINS;
+
+  uint8_t choices = rand();
+  uint8_t first = choices & (ProximitySensor::JITTER_BINS - 1);
+  uint8_t second = (choices >> 3) & (ProximitySensor::JITTER_BINS - 1);
+  int32_t firstNoise = 0;
+  int32_t secondNoise = 0;
+  for (uint8_t i=0; i < m_count; i++) {
+    ProximitySensor* pSensor = m_ppSensors[i];
+    if (!pSensor->m_adaptiveJitter || !pSensor->isHealthy()) continue;
+    firstNoise += pSensor->m_jitterNoise[first];
+    secondNoise += pSensor->m_jitterNoise[second];
+  }
+
+  uint8_t bin = firstNoise <= secondNoise ? first : second;
+  for (uint8_t i=0; i < m_count; i++) {
+    m_ppSensors[i]->m_jitterBin = bin;
+  }
+  return bin;
+}
+
+inline void ProximitySensorArray::settle(const uint8_t bin) {
+  if (bin < ProximitySensor::JITTER_BINS) ProximitySensor::jitterDelay(bin);
+  else ProximitySensor::randomDelay();
+}
+
+void ProximitySensorArray::acquirePair() {
+
+  // Both settle windows use the same timing, as a single sensor's two
+  // charge delays do.
+  uint8_t bin = selectJitterBin();
+
+  cli();
+
+  // Discharge every sensor cap. The S&H cap is grounded for the
+  // longest discharge delay required by any sensor in the array.
+  uint16_t dischargeDelayLoops = 0;
+  for (uint8_t i=0; i < m_count; i++) {
+    if (!m_ppSensors[i]->isHealthy()) continue;
+    m_ppSensors[i]->m_pSensorPin->pin().startDischarge();
+    if (m_ppSensors[i]->m_dischargeDelayLoops > dischargeDelayLoops) {
+      dischargeDelayLoops = m_ppSensors[i]->m_dischargeDelayLoops;
+    }
+  }
+
+  // Ground Mux and discharge S&H cap
+  ADMUX |= 0b11111;
+
+  if (dischargeDelayLoops) _delay_loop_2(dischargeDelayLoops);
+
+  settle(bin);
+
+  // Let sensor pins float
+  for (uint8_t i=0; i < m_count; i++) {
+    if (m_ppSensors[i]->isHealthy()) m_ppSensors[i]->m_pSensorPin->pin().stopDischarge();
+  }
+
+  for (uint8_t i=0; i < m_count; i++) {
+    ProximitySensor* pSensor = m_ppSensors[i];
+    if (!pSensor->isHealthy()) continue;
+    // Connect reference pin to S&H cap and charge it
+    pSensor->m_pReferencePin->select();
+    pSensor->m_pReferencePin->pin().startCharge();
+    _delay_us(SH_TRANSFER_DELAY_US);
+    // Connect sensor pin to S&H cap
+    pSensor->m_pSensorPin->select();
+    pSensor->m_arrayDifference = -(int16_t)ProximitySensor::getAdcSample();
+  }
+
+  sei();
+
+  cli();
+
+  // Charge every sensor cap
+  for (uint8_t i=0; i < m_count; i++) {
+    if (m_ppSensors[i]->isHealthy()) m_ppSensors[i]->m_pSensorPin->pin().startCharge();
+  }
+
+  settle(bin);
+
+  // Let sensor pins float
+  for (uint8_t i=0; i < m_count; i++) {
+    if (m_ppSensors[i]->isHealthy()) m_ppSensors[i]->m_pSensorPin->pin().stopCharge();
+  }
+
+  for (uint8_t i=0; i < m_count; i++) {
+    ProximitySensor* pSensor = m_ppSensors[i];
+    if (!pSensor->isHealthy()) continue;
+    // Connect reference pin to S&H cap and discharge it
+    pSensor->m_pReferencePin->select();
+    pSensor->m_pReferencePin->pin().startDischarge();
+    _delay_us(SH_TRANSFER_DELAY_US);
+    // Connect sensor pin to S&H cap
+    pSensor->m_pSensorPin->select();
+    pSensor->m_arrayDifference += ProximitySensor::getAdcSample();
+  }
+
+  sei();
+
+  for (uint8_t i=0; i < m_count; i++) {
+    ProximitySensor* pSensor = m_ppSensors[i];
+    if (!pSensor->isHealthy()) continue;
+    pSensor->m_stepTotal += pSensor->m_arrayDifference;
+    if (pSensor->m_adaptiveJitter) pSensor->recordJitterNoise(pSensor->m_arrayDifference);
+#if PROXIMITY_FEATURE(SAMPLE_CALLBACK)
+    if (pSensor->m_onSampleCallback) (*pSensor->m_onSampleCallback)(pSensor->m_onSampleCallbackData);
+#endif
+  }
+}
+
+void ProximitySensorArray::update(uint32_t* pSamples) {
+
+  // Any stepped acquisition in progress on a sensor is discarded. Each
+  // sensor runs its scheduled checks; sensors that are not HEALTHY are
+  // left out of the acquisition.
+  uint8_t healthy = 0;
+  for (uint8_t i=0; i < m_count; i++) {
+    m_ppSensors[i]->m_stepTotal = 0;
+    m_ppSensors[i]->m_stepCount = 0;
+    healthy += m_ppSensors[i]->prepareUpdate();
+  }
+
+  uint16_t sampleCount = healthy ? _BV(m_resolution) : 0;
+
+  for (uint16_t i=0; i < sampleCount; i++) {
+    acquirePair();
+  }
+
+  // Samples go through the same hum filter and state machine as
+  // ProximitySensor::update().
+  for (uint8_t i=0; i < m_count; i++) {
+    ProximitySensor* pSensor = m_ppSensors[i];
+    uint32_t sample = 0;
+    if (pSensor->isHealthy()) {
+      sample = pSensor->update(pSensor->filterHum((pSensor->m_stepTotal >> m_resolution) << 8)) >> 8;
+      pSensor->m_stepTotal = 0;
+    }
+    if (pSamples) pSamples[i] = sample;
+  }
+}
@@ -0,0 +1,69 @@
+/*
+ * SampleTimer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <SampleTimer.h>
+#include <avr/interrupt.h>
+
+volatile uint32_t SampleTimer::s_tick = 0;
+uint16_t SampleTimer::s_rateHz = 0;
+
+uint16_t SampleTimer::begin(const uint16_t rateHz) {
+
+  // Clock select bits and divisors for the Timer3 prescaler.
+  static const uint8_t clockSelect[] = {
+    _BV(CS30), _BV(CS31), _BV(CS31) | _BV(CS30), _BV(CS32), _BV(CS32) | _BV(CS30)
+  };
+  static const uint16_t divisor[] = { 1, 8, 64, 256, 1024 };
+
+  if (rateHz == 0) {
+    end();
+    return s_rateHz = 0;
+  }
+
+  uint8_t index = 0;
+  uint32_t count = F_CPU / rateHz;
+  while (count > 65536UL && index < sizeof(divisor) / sizeof(divisor[0]) - 1) {
+    index++;
+    count = F_CPU / ((uint32_t)divisor[index] * rateHz);
+  }
+  if (count > 65536UL) count = 65536UL;
+  if (count < 1) count = 1;
+
+  uint8_t sreg = SREG;
+  cli();
+  // CTC mode with TOP at OCR3A.
+  TCCR3A = 0;
+  TCCR3B = 0;
+  TCNT3 = 0;
+  OCR3A = count - 1;
+  s_tick = 0;
+  s_rateHz = F_CPU / ((uint32_t)divisor[index] * count);
+  TIFR3 = _BV(OCF3A);
+  TIMSK3 |= _BV(OCIE3A);
+  TCCR3B = _BV(WGM32) | clockSelect[index];
+  SREG = sreg;
+
+  return s_rateHz;
+}
+
+void SampleTimer::end() {
+  TIMSK3 &= ~_BV(OCIE3A);
+  TCCR3B = 0;
+}
+
+uint32_t SampleTimer::getTick() {
+  uint8_t sreg = SREG;
+  cli();
+  uint32_t tick = s_tick;
+  SREG = sreg;
+  return tick;
+}
+
+uint32_t SampleTimer::ticksToMs(const uint32_t ticks) {
+  if (s_rateHz == 0) return 0;
+  // Split to avoid overflowing ticks * 1000.
+  return (ticks / s_rateHz) * 1000 + ((ticks % s_rateHz) * 1000) / s_rateHz;
+}
@@ -0,0 +1,305 @@
+/*
+ * SensorConsole.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include <SensorConsole.h>
+
+#ifdef AVR_PROJECT_BUILD
+#include "timer.h"
+#else
+#include <Arduino.h>
+#endif
+
+// SYNC, length and type before the payload and check after it.
+#define FRAME_OVERHEAD 4
+#define TELEMETRY_LENGTH 8
+#define MAX_FRAME (FRAME_OVERHEAD + TELEMETRY_LENGTH)
+
+// Telemetry covers the sensors whose bits fit in the mask.
+#define TELEMETRY_SENSORS 16
+
+/**
+ * Payload length of each command, indexed by Command.
+ */
+static const uint8_t COMMAND_LENGTHS[] = { 0, 0, 2, 6, 4, 1, 1 };
+
+static uint8_t toByte(const uint32_t value) {
+  return value > 0xFF ? 0xFF : value;
+}
+
+static uint16_t toWord(const uint32_t value) {
+  return value > 0xFFFF ? 0xFFFF : value;
+}
+
+SensorConsole::SensorConsole(Stream& stream, ProximitySensor* const* ppSensors, const uint8_t count)
+: m_stream(stream)
+, m_pSensor(0)
+, m_ppSensors(ppSensors)
+, m_count(count)
+, m_receiveState(RECEIVE_SYNC)
+, m_receiveLength(0)
+, m_receiveIndex(0)
+, m_receiveCheck(0)
+, m_receiveType(0)
+, m_telemetryMask(0)
+, m_telemetryDecimation(0)
+, m_telemetryCountdown(0)
+, m_telemetryDropped(0)
+, m_frameErrors(0)
+{
+}
+
+SensorConsole::SensorConsole(Stream& stream, ProximitySensor& sensor)
+: m_stream(stream)
+, m_pSensor(&sensor)
+, m_ppSensors(&m_pSensor)
+, m_count(1)
+, m_receiveState(RECEIVE_SYNC)
+, m_receiveLength(0)
+, m_receiveIndex(0)
+, m_receiveCheck(0)
+, m_receiveType(0)
+, m_telemetryMask(0)
+, m_telemetryDecimation(0)
+, m_telemetryCountdown(0)
+, m_telemetryDropped(0)
+, m_frameErrors(0)
+{
+}
+
+void SensorConsole::poll(const uint32_t* pSamples) {
+  if (m_telemetryMask && --m_telemetryCountdown == 0) {
+    m_telemetryCountdown = m_telemetryDecimation;
+    sendTelemetry(pSamples);
+  }
+  if (m_stream.available() > 0) receive();
+}
+
+void SensorConsole::receive() {
+  // Only the bytes already received are consumed, so this never waits.
+  while (m_stream.available() > 0) {
+    uint8_t byte = m_stream.read();
+    switch (m_receiveState) {
+    case RECEIVE_SYNC:
+      if (byte == SYNC) m_receiveState = RECEIVE_LENGTH;
+      break;
+    case RECEIVE_LENGTH:
+      if (byte > MAX_PAYLOAD) {
+        m_frameErrors++;
+        m_receiveType = 0;
+        m_receiveState = RECEIVE_SYNC;
+        sendError(BAD_LENGTH);
+        break;
+      }
+      m_receiveLength = byte;
+      m_receiveCheck = byte;
+      m_receiveIndex = 0;
+      m_receiveState = RECEIVE_TYPE;
+      break;
+    case RECEIVE_TYPE:
+      m_receiveType = byte;
+      m_receiveCheck ^= byte;
+      m_receiveState = m_receiveLength ? RECEIVE_PAYLOAD : RECEIVE_CHECK;
+      break;
+    case RECEIVE_PAYLOAD:
+      m_receivePayload[m_receiveIndex++] = byte;
+      m_receiveCheck ^= byte;
+      if (m_receiveIndex == m_receiveLength) m_receiveState = RECEIVE_CHECK;
+      break;
+    default:
+      m_receiveState = RECEIVE_SYNC;
+      if (byte != m_receiveCheck) {
+        m_frameErrors++;
+        sendError(BAD_CHECK);
+        break;
+      }
+      execute();
+      break;
+    }
+  }
+}
+
+void SensorConsole::execute() {
+
+  const uint8_t* p = m_receivePayload;
+
+  if (m_receiveType < PING || m_receiveType > CALIBRATE) {
+    sendError(UNKNOWN_COMMAND);
+    return;
+  }
+  if (m_receiveLength != COMMAND_LENGTHS[m_receiveType]) {
+    sendError(BAD_LENGTH);
+    return;
+  }
+
+  if (m_receiveType == PING) {
+    uint8_t reply[] = { PROTOCOL_VERSION, m_count, PROXIMITY_FEATURES };
+    send(PING | REPLY, reply, sizeof(reply));
+    return;
+  }
+
+  if (m_receiveType == SUBSCRIBE) {
+    m_telemetryDecimation = p[2] | (p[3] << 8);
+    m_telemetryMask = m_telemetryDecimation ? p[0] | (p[1] << 8) : 0;
+    m_telemetryCountdown = m_telemetryDecimation;
+    send(SUBSCRIBE | REPLY, p, 4);
+    return;
+  }
+
+  // The remaining commands address one sensor, or all of them except
+  // for GET.
+  uint8_t first = p[0];
+  uint8_t last = p[0];
+  if (first == ALL_SENSORS && m_receiveType != GET && m_count) {
+    first = 0;
+    last = m_count - 1;
+  }
+  else if (first >= m_count) {
+    sendError(BAD_SENSOR);
+    return;
+  }
+
+  uint8_t parameter = p[1];
+  uint32_t value = 0;
+
+  for (uint8_t i = first; i <= last; i++) {
+    ProximitySensor& sensor = *m_ppSensors[i];
+    switch (m_receiveType) {
+    case GET:
+      if (!get(sensor, parameter, value)) {
+        sendError(UNKNOWN_PARAMETER);
+        return;
+      }
+      break;
+    case SET:
+      value = p[2] | ((uint32_t)p[3] << 8) | ((uint32_t)p[4] << 16) | ((uint32_t)p[5] << 24);
+      if (!set(sensor, parameter, value)) {
+        sendError(get(sensor, parameter, value) ? PARAMETER_READ_ONLY : UNKNOWN_PARAMETER);
+        return;
+      }
+      break;
+    case RESEED:
+      sensor.reseed();
+      break;
+    default:
+      parameter = DISCHARGE_DELAY_US;
+      value = sensor.calibrateDischargeDelay();
+      break;
+    }
+  }
+
+  if (m_receiveType == RESEED) send(RESEED | REPLY, p, 1);
+  else sendValue(p[0], parameter, value);
+}
+
+bool SensorConsole::get(ProximitySensor& sensor, const uint8_t parameter, uint32_t& value) {
+  switch (parameter) {
+  case RESOLUTION: value = sensor.getResolution(); break;
+  case FILTER_ADAPTATION_RATE: value = sensor.getFilterAdaptationRate(); break;
+#if PROXIMITY_FEATURE(RESEED)
+  case FILTER_RESEED_THRESHOLD: value = sensor.getFilterReseedThreshold(); break;
+#endif
+  case PROXIMITY_THRESHOLD: value = sensor.getProximityThreshold(); break;
+  case TOUCH_THRESHOLD: value = sensor.getTouchThreshold(); break;
+  case RELEASE_THRESHOLD: value = sensor.getReleaseThreshold(); break;
+#if PROXIMITY_FEATURE(DEBOUNCE)
+  case DELAY_MS: value = sensor.getDelayMs(); break;
+#endif
+#if PROXIMITY_FEATURE(TIMEOUTS)
+  case PROXIMITY_TIMEOUT_MS: value = sensor.getProximityTimeoutMs(); break;
+  case TOUCH_TIMEOUT_MS: value = sensor.getTouchTimeoutMs(); break;
+#endif
+  case DISCHARGE_DELAY_US: value = sensor.getDischargeDelayUs(); break;
+  case DISCHARGE_DELAY_VERIFY_INTERVAL: value = sensor.getDischargeDelayVerifyInterval(); break;
+  case DISCHARGED_REFERENCE_INTERVAL: value = sensor.getDischargedReferenceInterval(); break;
+  case ADAPTIVE_JITTER: value = sensor.isAdaptiveJitter(); break;
+  case HEALTH_CHECK_INTERVAL: value = sensor.getHealthCheckInterval(); break;
+  case OPEN_THRESHOLD: value = sensor.getOpenThreshold(); break;
+  case STATE: value = sensor.getState(); break;
+  case MOVING_AVERAGE: value = sensor.getMovingAverage(); break;
+  case DISCHARGED_REFERENCE_DEVIATION: value = sensor.getDischargedReferenceDeviation(); break;
+  case QUIETEST_JITTER_DELAY_US: value = sensor.getQuietestJitterDelayUs(); break;
+  case MISSED_TICKS: value = sensor.getMissedTicks(); break;
+  case HEALTH: value = sensor.getHealth(); break;
+  default: return false;
+  }
+  return true;
+}
+
+bool SensorConsole::set(ProximitySensor& sensor, const uint8_t parameter, uint32_t& value) {
+  switch (parameter) {
+  case RESOLUTION: value = sensor.setResolution(toByte(value)); break;
+  case FILTER_ADAPTATION_RATE: value = sensor.setFilterAdaptationRate(toByte(value)); break;
+#if PROXIMITY_FEATURE(RESEED)
+  case FILTER_RESEED_THRESHOLD: value = sensor.setFilterReseedThreshold(toByte(value)); break;
+#endif
+  case PROXIMITY_THRESHOLD: value = sensor.setProximityThreshold(toByte(value)); break;
+  case TOUCH_THRESHOLD: value = sensor.setTouchThreshold(toByte(value)); break;
+  case RELEASE_THRESHOLD: value = sensor.setReleaseThreshold(toByte(value)); break;
+#if PROXIMITY_FEATURE(DEBOUNCE)
+  case DELAY_MS: value = sensor.setDelayMs(value); break;
+#endif
+#if PROXIMITY_FEATURE(TIMEOUTS)
+  case PROXIMITY_TIMEOUT_MS: value = sensor.setProximityTimeoutMs(value); break;
+  case TOUCH_TIMEOUT_MS: value = sensor.setTouchTimeoutMs(value); break;
+#endif
+  case DISCHARGE_DELAY_US: value = sensor.setDischargeDelayUs(toByte(value)); break;
+  case DISCHARGE_DELAY_VERIFY_INTERVAL: value = sensor.setDischargeDelayVerifyInterval(toWord(value)); break;
+  case DISCHARGED_REFERENCE_INTERVAL: value = sensor.setDischargedReferenceInterval(toByte(value)); break;
+  case ADAPTIVE_JITTER: value = sensor.setAdaptiveJitter(value != 0); break;
+  case HEALTH_CHECK_INTERVAL: value = sensor.setHealthCheckInterval(toWord(value)); break;
+  case OPEN_THRESHOLD: value = sensor.setOpenThreshold(toWord(value)); break;
+  default: return false;
+  }
+  return true;
+}
+
+void SensorConsole::sendTelemetry(const uint32_t* pSamples) {
+  uint16_t timeMs = millis();
+  for (uint8_t i = 0; i < m_count && i < TELEMETRY_SENSORS; i++) {
+    if (!(m_telemetryMask & (1U << i))) continue;
+    if (m_stream.availableForWrite() < MAX_FRAME) {
+      m_telemetryDropped++;
+      continue;
+    }
+    const ProximitySensor& sensor = *m_ppSensors[i];
+    uint16_t sample = pSamples ? toWord(pSamples[i]) : 0;
+    uint16_t average = toWord(sensor.getMovingAverage());
+    uint8_t payload[TELEMETRY_LENGTH] = {
+      i, (uint8_t)sensor.getState(),
+      (uint8_t)timeMs, (uint8_t)(timeMs >> 8),
+      (uint8_t)sample, (uint8_t)(sample >> 8),
+      (uint8_t)average, (uint8_t)(average >> 8)
+    };
+    send(TELEMETRY, payload, TELEMETRY_LENGTH);
+  }
+}
+
+void SensorConsole::sendValue(const uint8_t sensor, const uint8_t parameter, const uint32_t value) {
+  uint8_t payload[] = {
+    sensor, parameter, (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)
+  };
+  send(m_receiveType | REPLY, payload, sizeof(payload));
+}
+
+void SensorConsole::sendError(const uint8_t error) {
+  uint8_t payload[] = { m_receiveType, error };
+  send(ERROR, payload, sizeof(payload));
+}
+
+void SensorConsole::send(const uint8_t type, const uint8_t* pPayload, const uint8_t length) {
+  // Sent with a single write so that USB serial sends one packet.
+  uint8_t frame[MAX_FRAME];
+  uint8_t check = length ^ type;
+  frame[0] = SYNC;
+  frame[1] = length;
+  frame[2] = type;
+  for (uint8_t i = 0; i < length; i++) {
+    frame[3 + i] = pPayload[i];
+    check ^= pPayload[i];
+  }
+  frame[3 + length] = check;
+  m_stream.write(frame, FRAME_OVERHEAD + length);
+}